@@ -0,0 +1,54 @@
+#include "ChangeBatch.h"
+
+ChangeBatch::ChangeBatch(const std::vector<DirectoryMonitor::ChangeInfo>& changes) {
+	using ChangeInfo = DirectoryMonitor::ChangeInfo;
+
+	for (const ChangeInfo& change : changes) {
+		switch (change.type) {
+			case ChangeInfo::ADDED:
+			case ChangeInfo::MODIFIED:
+				loads.insert_or_assign(Canonical(change.path), Load { change.path, change.contents });
+				break;
+
+			case ChangeInfo::DELETED:
+				loads.erase(Canonical(change.path));
+				moves.push_back(change);
+				break;
+
+			case ChangeInfo::RENAMED: {
+				const fs::path old_canonical = Canonical(change.old_path);
+				const fs::path new_canonical = Canonical(change.path);
+				auto           pending       = loads.extract(old_canonical);
+				loads.erase(new_canonical); // Renamed over, whatever was written there is gone
+
+				if (pending.empty()) {
+					moves.push_back(change);
+					break;
+				}
+
+				// Written and then renamed in the same tick: drop the old entry and load the file where it is now
+				pending.mapped().path = change.path;
+				pending.key()         = new_canonical;
+				loads.insert(std::move(pending));
+				moves.push_back({ ChangeInfo::DELETED, change.old_path, {}, nullptr });
+				break;
+			}
+		}
+	}
+}
+
+const std::vector<DirectoryMonitor::ChangeInfo>& ChangeBatch::GetMoves() const {
+	return moves;
+}
+
+const std::unordered_map<fs::path, ChangeBatch::Load>& ChangeBatch::GetLoads() const {
+	return loads;
+}
+
+fs::path ChangeBatch::Canonical(const fs::path& path) {
+	try {
+		return fs::weakly_canonical(path);
+	} catch (...) {
+		return path; // fallback to original
+	}
+}
@@ -0,0 +1,36 @@
+#ifndef CHANGEBATCH_H_
+#define CHANGEBATCH_H_
+
+#include "DirectoryMonitor.h"
+
+#include <filesystem>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/* One tick of monitor changes, resolved into what the store has to do. Deletions and renames keep the order they happened
+ * in, so a chain through the same paths (x->t, y->x, t->y) moves every entry where it ended up. Additions and
+ * modifications are coalesced by canonical path and follow the renames they were caught in, they run after the moves. */
+class ChangeBatch {
+public:
+	/* A file to load once the moves are applied, at the path it ended up under */
+	struct Load {
+		std::filesystem::path                                 path;
+		std::shared_ptr<const DirectoryMonitor::FileContents> contents;
+	};
+
+	explicit ChangeBatch(const std::vector<DirectoryMonitor::ChangeInfo>& changes);
+
+	// DELETED and RENAMED only, to apply in this order. A rename of a file that is loaded anyway comes as a deletion.
+	[[nodiscard]] const std::vector<DirectoryMonitor::ChangeInfo>&       GetMoves() const;
+	// Keyed by canonical path
+	[[nodiscard]] const std::unordered_map<std::filesystem::path, Load>& GetLoads() const;
+
+	static std::filesystem::path                                         Canonical(const std::filesystem::path& path);
+
+private:
+	std::vector<DirectoryMonitor::ChangeInfo>       moves;
+	std::unordered_map<std::filesystem::path, Load> loads;
+};
+
+#endif /*! CHANGEBATCH_H_ */
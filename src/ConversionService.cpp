@@ -0,0 +1,97 @@
+#include "ConversionService.h"
+
+#include "Debug.h"
+
+ConversionService::ConversionService(Convert convert)
+    : convert(std::move(convert)),
+      thread(&ConversionService::Run, this) {
+}
+
+ConversionService::~ConversionService() {
+	Stop();
+}
+
+void ConversionService::Request(const std::string& region, Finished on_finished) {
+	std::optional<Job> superseded;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (stopping)
+			return;
+
+		if (pending_job) {
+			DEBUG_LOG("Conversion to " << pending_job->region << " superseded before it started.");
+			superseded = std::move(pending_job);
+		}
+		pending_job = Job { region, std::move(on_finished) };
+
+		// A conversion to the same region is still worth finishing, the queued pass only picks up what it missed
+		if (running && running_region != region) {
+			cancelled = true;
+		}
+		busy = true;
+	}
+	condition_variable.notify_one();
+
+	// Outside the lock, the caller may request again from its callback
+	if (superseded && superseded->on_finished) {
+		superseded->on_finished(Outcome::SUPERSEDED);
+	}
+}
+
+void ConversionService::Stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		pending_job.reset();
+		cancelled = true;
+	}
+	condition_variable.notify_one();
+
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+bool ConversionService::IsBusy() const {
+	return busy.load();
+}
+
+void ConversionService::Run() {
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (true) {
+		condition_variable.wait(lock, [this]() {
+			return stopping || pending_job.has_value();
+		});
+
+		if (stopping)
+			break;
+
+		Job job = std::move(*pending_job);
+		pending_job.reset();
+		running_region = job.region;
+		running        = true;
+		cancelled      = false;
+		lock.unlock();
+
+		// Only convert knows whether cancelled stopped it, a request for another region after its last file does not undo it
+		const bool converted = convert(job.region, cancelled);
+
+		lock.lock();
+		running = false;
+		busy    = pending_job.has_value();
+
+		if (!converted) {
+			DEBUG_LOG("Conversion to " << job.region << (cancelled ? " cancelled." : " failed."));
+		}
+
+		if (job.on_finished && !stopping) {
+			lock.unlock();
+			job.on_finished(converted ? Outcome::CONVERTED : Outcome::CANCELLED);
+			lock.lock();
+		}
+	}
+
+	running = false;
+	busy    = false;
+}
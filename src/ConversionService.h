@@ -0,0 +1,60 @@
+#ifndef CONVERSIONSERVICE_H_
+#define CONVERSIONSERVICE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+/* Runs region conversions on one background thread so the UI thread never waits on the disk. Only the newest request is
+ * kept: asking for another region cancels the conversion in progress, asking for the same one queues a second pass after it. */
+class ConversionService {
+public:
+	enum class Outcome {
+		CONVERTED,  // Every file was converted
+		CANCELLED,  // Ran, but a request for another region stopped it before the last file, or it failed
+		SUPERSEDED  // Replaced by a newer request before it started, nothing was converted
+	};
+
+	// Returns false when the conversion could not run or cancelled stopped it before the last file. Expected to poll cancelled between files.
+	using Convert  = std::function<bool(const std::string& region, const std::atomic<bool>& cancelled)>;
+	using Finished = std::function<void(Outcome outcome)>;
+
+	explicit ConversionService(Convert convert);
+	~ConversionService();
+	ConversionService(const ConversionService& other)            = delete;
+	ConversionService& operator=(const ConversionService& other) = delete;
+
+	// on_finished runs once per request: on the service thread once the job ran, or on the thread of the request that
+	// superseded it. A job that converted every file is CONVERTED even if a newer request came in after.
+	void               Request(const std::string& region, Finished on_finished = {});
+	void               Stop(); // Cancels the running conversion and joins the thread, neither it nor a queued job is told
+
+	[[nodiscard]] bool IsBusy() const;
+
+private:
+	struct Job {
+		std::string region;
+		Finished    on_finished;
+	};
+
+	Convert                 convert;
+
+	std::mutex              mutex;
+	std::condition_variable condition_variable;
+	std::optional<Job>      pending_job; // A queue of one, a newer request replaces it
+	std::string             running_region;
+	bool                    running   = false;
+	bool                    stopping  = false;
+	std::atomic<bool>       cancelled = false;
+	std::atomic<bool>       busy      = false;
+
+	std::thread             thread;
+
+	void                    Run();
+};
+
+#endif /*! CONVERSIONSERVICE_H_ */
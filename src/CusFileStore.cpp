@@ -0,0 +1,230 @@
+#include "CusFileStore.h"
+
+#include <algorithm>
+
+std::filesystem::path CusFile::GetRelativePath() const {
+	return std::filesystem::path(path);
+}
+
+uint32_t CusFile::GetSlotId() const {
+	return node_index;
+}
+
+const CusFileSnapshot::Region* CusFileSnapshot::FindRegion(std::string_view region) const {
+	for (const std::shared_ptr<const Region>& candidate : regions) {
+		if (candidate->region == region)
+			return candidate.get();
+	}
+	return nullptr;
+}
+
+const CusFileSnapshot::File& CusFileSnapshot::Region::At(size_t row) const {
+	// The last chunk starting at or before the row holds it
+	const size_t chunk = std::upper_bound(first_rows.begin(), first_rows.end(), row) - first_rows.begin() - 1;
+	return (*chunks[chunk])[row - first_rows[chunk]];
+}
+
+size_t CusFileSnapshot::Size() const {
+	size_t size = 0;
+	for (const std::shared_ptr<const Region>& region : regions) {
+		size += region->size;
+	}
+	return size;
+}
+
+std::pair<CusFile*, bool> CusFileStore::Insert(const std::filesystem::path& relative_path) {
+	const auto inserted = files.TryEmplace(relative_path.native());
+	if (inserted.second) {
+		inserted.first->serial = next_serial++;
+	}
+	return inserted;
+}
+
+CusFile* CusFileStore::Find(const std::filesystem::path& relative_path) const {
+	return files.Find(relative_path.native());
+}
+
+void CusFileStore::Erase(CusFile* file) {
+	Unlink(file);
+	files.Erase(file);
+	files.CompactPaths();
+}
+
+bool CusFileStore::Erase(const std::filesystem::path& relative_path) {
+	CusFile* file = Find(relative_path);
+	if (!file)
+		return false;
+
+	Erase(file);
+	return true;
+}
+
+void CusFileStore::Rename(CusFile* file, const std::filesystem::path& new_relative_path) {
+	MarkChanged(file);
+	files.Rekey(file, new_relative_path.native());
+	files.CompactPaths();
+}
+
+void CusFileStore::SetRegion(CusFile* file, std::string_view region) {
+	if (file->region == region)
+		return; // Already linked there
+
+	Unlink(file);
+	file->region             = region;
+
+	RegionList& list         = FindOrAddRegion(region);
+	file->previous_in_region = list.tail;
+	file->next_in_region     = nullptr;
+	if (list.tail) {
+		list.tail->next_in_region = file;
+	} else {
+		list.head = file;
+	}
+	list.tail = file;
+	list.count++;
+	list.dirty = true;
+
+	// The last run ends at the tail, so the file joins it unless it is full
+	if (list.chunks.empty() || list.chunks.back()->count >= CHUNK_SIZE) {
+		list.chunks.push_back(std::make_unique<CusFileChunk>());
+		list.chunks.back()->first = file;
+	}
+	file->chunk = list.chunks.back().get();
+	file->chunk->count++;
+	file->chunk->dirty = true;
+}
+
+void CusFileStore::SetInfo(CusFile* file, const FileInfo& info) {
+	file->info = info;
+	MarkChanged(file);
+}
+
+void CusFileStore::Clear() {
+	files.Clear();
+	regions.clear();
+	regions_removed = true;
+}
+
+void CusFileStore::Publish() {
+	const std::shared_ptr<const CusFileSnapshot> previous = snapshot.load();
+	const bool                                   changed  = regions_removed || regions.size() != previous->regions.size() || std::ranges::any_of(regions, &RegionList::dirty);
+	if (!changed)
+		return;
+
+	auto next     = std::make_shared<CusFileSnapshot>();
+	next->version = previous->version + 1;
+	next->regions.reserve(regions.size());
+
+	// Regions are only ever appended until Clear, so an index names the same region in both snapshots
+	for (size_t index = 0; index < regions.size(); ++index) {
+		RegionList& list = regions[index];
+		if (!list.dirty && !regions_removed && index < previous->regions.size()) {
+			next->regions.push_back(previous->regions[index]);
+			continue;
+		}
+
+		// Only the runs that changed are copied, the others hand over the chunk they were last published as
+		auto region    = std::make_shared<CusFileSnapshot::Region>();
+		region->region = list.region;
+		region->size   = list.count;
+		region->chunks.reserve(list.chunks.size());
+		region->first_rows.reserve(list.chunks.size());
+		for (const std::unique_ptr<CusFileChunk>& chunk : list.chunks) {
+			if (chunk->dirty || !chunk->published) {
+				auto           chunk_files = std::make_shared<CusFileSnapshot::Chunk>();
+				const CusFile* file        = chunk->first;
+				chunk_files->reserve(chunk->count);
+				for (size_t index = 0; index < chunk->count; ++index, file = file->next_in_region) {
+					chunk_files->push_back({ file->GetRelativePath(), file->info, file->serial, file->invalid });
+				}
+				chunk->published = std::move(chunk_files);
+				chunk->dirty     = false;
+			}
+
+			region->first_rows.push_back(region->first_rows.empty() ? 0 : region->first_rows.back() + region->chunks.back()->size());
+			region->chunks.push_back(chunk->published);
+		}
+
+		next->regions.push_back(std::move(region));
+		list.dirty = false;
+	}
+
+	regions_removed = false;
+	snapshot.store(std::move(next));
+}
+
+std::shared_ptr<const CusFileSnapshot> CusFileStore::GetSnapshot() const {
+	return snapshot.load();
+}
+
+size_t CusFileStore::Size() const {
+	return files.Size();
+}
+
+size_t CusFileStore::CountInRegion(std::string_view region) const {
+	const RegionList* list = FindRegion(region);
+	return list ? list->count : 0;
+}
+
+const CusFileStore::RegionList* CusFileStore::FindRegion(std::string_view region) const {
+	for (const RegionList& list : regions) {
+		if (list.region == region)
+			return &list;
+	}
+	return nullptr;
+}
+
+CusFileStore::RegionList& CusFileStore::FindOrAddRegion(std::string_view region) {
+	for (RegionList& list : regions) {
+		if (list.region == region)
+			return list;
+	}
+	RegionList& list = regions.emplace_back();
+	list.region      = region;
+	return list;
+}
+
+void CusFileStore::MarkChanged(CusFile* file) {
+	if (!file->chunk)
+		return; // Not in a region, so in no snapshot either
+
+	file->chunk->dirty                  = true;
+	FindOrAddRegion(file->region).dirty = true;
+}
+
+void CusFileStore::Unlink(CusFile* file) {
+	if (file->region.empty())
+		return; // Only SetRegion assigns a region, so a file with one is always linked
+
+	RegionList&   list  = FindOrAddRegion(file->region);
+	CusFileChunk* chunk = file->chunk;
+	if (chunk->first == file) {
+		chunk->first = file->next_in_region;
+	}
+	chunk->count--;
+	chunk->dirty = true;
+	if (chunk->count == 0) {
+		std::erase_if(list.chunks, [chunk](const std::unique_ptr<CusFileChunk>& candidate) {
+			return candidate.get() == chunk;
+		});
+	}
+
+	if (file->previous_in_region) {
+		file->previous_in_region->next_in_region = file->next_in_region;
+	} else {
+		list.head = file->next_in_region;
+	}
+
+	if (file->next_in_region) {
+		file->next_in_region->previous_in_region = file->previous_in_region;
+	} else {
+		list.tail = file->previous_in_region;
+	}
+
+	file->previous_in_region = nullptr;
+	file->next_in_region     = nullptr;
+	file->chunk              = nullptr;
+	file->region.clear();
+	list.count--;
+	list.dirty = true;
+}
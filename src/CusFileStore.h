@@ -0,0 +1,154 @@
+#ifndef CUSFILESTORE_H_
+#define CUSFILESTORE_H_
+
+#include "FileInfo.h"
+#include "FlatPathMap.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class CusFileStore;
+struct CusFileChunk;
+
+/* Only the header is ever read, conversion patches the region bytes in place. Nothing of the body stays resident.
+ * The key is the path relative to the customizing directory, interned once by the store. */
+struct CusFile : FlatPathMapNode {
+	std::string                         region; // Set through CusFileStore::SetRegion only, it keeps the region lists
+	bool                                invalid = false;
+	uint64_t                            serial  = 0; // Assigned by the store on insertion and never reused, unlike the slot
+	FileInfo                            info; // Set through CusFileStore::SetInfo only. Identity, metadata and hash as of the last read or write, hash 0 after a conversion until the monitor rehashes it.
+
+	[[nodiscard]] std::filesystem::path GetRelativePath() const;
+	[[nodiscard]] uint32_t              GetSlotId() const; // Stable for as long as the file is in the store, renames included
+
+private:
+	friend class CusFileStore;
+
+	CusFile*                            previous_in_region = nullptr;
+	CusFile*                            next_in_region     = nullptr;
+	CusFileChunk*                       chunk              = nullptr; // The run of its region list it is published in
+};
+
+/* Immutable copy of the store as of one CusFileStore::Publish, read without locking. Each region is cut into chunks of
+ * consecutive files, and a chunk nothing touched since the previous snapshot is shared with it rather than copied, so
+ * publishing a change costs one chunk plus a pointer per chunk of its region. */
+struct CusFileSnapshot {
+	struct File {
+		std::filesystem::path relative_path;
+		FileInfo              info;
+		uint64_t              serial; // CusFile::serial, follows the file across versions and renames
+		bool                  invalid = false;
+	};
+
+	using Chunk = std::vector<File>;
+
+	struct Region {
+		std::string                               region;
+		std::vector<std::shared_ptr<const Chunk>> chunks;     // In the order files joined the region, never empty
+		std::vector<size_t>                       first_rows; // Of each chunk
+		size_t                                    size = 0;
+
+		[[nodiscard]] const File&                 At(size_t row) const; // Row in join order, found in O(log chunks)
+
+		template <typename Function>
+		void ForEach(Function&& function) const {
+			for (const std::shared_ptr<const Chunk>& chunk : chunks) {
+				for (const File& file : *chunk) {
+					function(file);
+				}
+			}
+		}
+	};
+
+	std::vector<std::shared_ptr<const Region>> regions;
+	uint64_t                                   version = 0;
+
+	[[nodiscard]] const Region*                FindRegion(std::string_view region) const;
+	[[nodiscard]] size_t                       Size() const;
+};
+
+/* Store side of a snapshot chunk: a run of consecutive files in a region list. Files only ever join a region at its
+ * tail, so runs stay contiguous as files come and go, and a change marks only the run it falls in. */
+struct CusFileChunk {
+	CusFile*                                      first = nullptr;
+	size_t                                        count = 0;
+	bool                                          dirty = true; // Changed since published was built
+	std::shared_ptr<const CusFileSnapshot::Chunk> published;
+};
+
+/* Every loaded preset, found by relative path in O(1) and linked into an intrusive list per region, so loading, removing,
+ * renaming and converting a file never scan the others. Records stay at one address until they are erased. */
+class CusFileStore {
+public:
+	// Adds a file with no region yet, or returns the one already at the path
+	std::pair<CusFile*, bool> Insert(const std::filesystem::path& relative_path);
+	[[nodiscard]] CusFile*    Find(const std::filesystem::path& relative_path) const;
+	void                      Erase(CusFile* file);
+	bool                      Erase(const std::filesystem::path& relative_path);
+	void                      Rename(CusFile* file, const std::filesystem::path& new_relative_path); // The new path must be free
+	void                      SetRegion(CusFile* file, std::string_view region);
+	void                      SetInfo(CusFile* file, const FileInfo& info);
+	void                      Clear();
+
+	// Publishes the changes made since the last call as a new snapshot. Writers must be excluded, readers never are.
+	void                      Publish();
+	[[nodiscard]] std::shared_ptr<const CusFileSnapshot> GetSnapshot() const; // Lock-free, safe from any thread
+
+	[[nodiscard]] size_t      Size() const;
+	[[nodiscard]] size_t      CountInRegion(std::string_view region) const;
+
+	// In the order files joined the region. The function may move the file it is given to another region.
+	template <typename Function>
+	void ForEachInRegion(std::string_view region, Function&& function) {
+		const RegionList* list = FindRegion(region);
+		for (CusFile* file = list ? list->head : nullptr; file;) {
+			CusFile* next = file->next_in_region;
+			function(*file);
+			file = next;
+		}
+	}
+
+	template <typename Function>
+	void ForEachInRegion(std::string_view region, Function&& function) const {
+		const RegionList* list = FindRegion(region);
+		for (const CusFile* file = list ? list->head : nullptr; file; file = file->next_in_region) {
+			function(*file);
+		}
+	}
+
+	template <typename Function>
+	void ForEach(Function&& function) const {
+		files.ForEach(std::forward<Function>(function));
+	}
+
+private:
+	struct RegionList {
+		std::string                                region;
+		CusFile*                                   head  = nullptr;
+		CusFile*                                   tail  = nullptr;
+		size_t                                     count = 0;
+		bool                                       dirty = true; // Changed since the last Publish
+		std::vector<std::unique_ptr<CusFileChunk>> chunks;       // Cover the list in order, the last one takes appended files
+	};
+
+	static constexpr size_t                               CHUNK_SIZE = 256; // Files a chunk takes before the next one starts
+
+	FlatPathMap<CusFile>                                  files;
+	std::vector<RegionList>                               regions; // A handful at most, searched linearly
+	uint64_t                                              next_serial = 1;
+	std::atomic<std::shared_ptr<const CusFileSnapshot>>   snapshot { std::make_shared<const CusFileSnapshot>() };
+	bool                                                  regions_removed = false; // Cleared since the last Publish, nothing can be shared
+
+	[[nodiscard]] const RegionList*                       FindRegion(std::string_view region) const;
+	RegionList&                                           FindOrAddRegion(std::string_view region);
+	void                                                  MarkChanged(CusFile* file);
+	void                                                  Unlink(CusFile* file);
+};
+
+#endif /*! CUSFILESTORE_H_ */
@@ -1,10 +1,14 @@
 #include "CusManager.h"
 
+#include "ChangeBatch.h"
 #include "Debug.h"
 #include "DirectoryMonitor.h"
 #include "OperatingSystemFunctions.h"
+#include "ConversionService.h"
+#include "SnapshotIndex.h"
+#include "ThreadPool.h"
 
-#include <fstream>
+#include <algorithm>
 #include <ranges>
 #include <utility>
 
@@ -12,169 +16,263 @@ CusManager::CusManager(slint::ComponentHandle<AppWindow> ui)
     : ui_handle(std::move(ui)),
       selected_region(OperatingSystemFunctions::GetLocalizationRegion()),
       customizing_directory(OperatingSystemFunctions::FindLostArkCustomizationDirectory()),
-      directory_monitor(std::make_unique<DirectoryMonitor>(customizing_directory, true)),
-      slint_models_by_excluded_region {
-	      { "USA", std::make_shared<slint::VectorModel<SlintCusFile>>() },
-	      { "KOR", std::make_shared<slint::VectorModel<SlintCusFile>>() },
-	      { "RUS", std::make_shared<slint::VectorModel<SlintCusFile>>() }
-      },
-      region_files_map(std::unordered_map<std::string, std::vector<std::unique_ptr<CusFile>>> {}) {
+      snapshot_index(std::make_unique<SnapshotIndex>(OperatingSystemFunctions::GetApplicationDataDirectory() / "snapshot_index.bin")),
+      region_converter(std::make_unique<RegionConverter>()),
+      preset_model(std::make_shared<PresetListModel>(available_regions)),
+      ui_updates([this](std::vector<UiUpdateQueue::Update>& updates) { ApplyUiUpdates(updates); }, FRAME_INTERVAL) {
+
+	// One view per region over the single model, switching regions only hands the UI another one
+	auto region_names = std::make_shared<slint::VectorModel<slint::SharedString>>();
+	for (const std::string& region : available_regions) {
+		unconverted_views.emplace(region, PresetRegionView::Create(preset_model, region));
+		region_names->push_back(slint::SharedString(region));
+	}
+	ui_handle->global<GlobalVariables>().set_regions(region_names);
 
 	LoadFilesFromDisk();
 
+	const DirectoryMonitor::Seed seed = BuildMonitorSeed();
+	directory_monitor                 = std::make_unique<DirectoryMonitor>(customizing_directory, true, DirectoryMonitor::Backend::AUTOMATIC, scan_options, &seed);
+
+	conversion_service                = std::make_unique<ConversionService>([this](const std::string& region, const std::atomic<bool>& cancelled) {
+		return ConvertFilesToRegion(region, cancelled, conversion_result);
+	});
+
+	// Progress reaches the UI in batches, polled on the UI thread rather than pushed per file
+	progress_timer.start(slint::TimerMode::Repeated, PROGRESS_INTERVAL, [this]() {
+		PublishConversionProgress();
+	});
+#ifndef NDEBUG
+	// Developer counters, kept out of release builds like DEBUG_LOG
+	ui_handle->global<GlobalVariables>().set_show_diagnostics(true);
+	diagnostics_timer.start(slint::TimerMode::Repeated, DIAGNOSTICS_INTERVAL, [this]() {
+		PublishDiagnostics();
+	});
+#endif
+
 	StartMonitorThread();
 }
 
 CusManager::~CusManager() {
+	progress_timer.stop();
+	diagnostics_timer.stop();
 	StopMonitorThread();
+	conversion_service->Stop();
+	SaveSnapshotIndex();
 }
 
-void CusManager::LoadFile(const std::filesystem::path& full_path) {
+void CusManager::LoadFile(const std::filesystem::path& full_path, const DirectoryMonitor::FileContents* contents) {
 	if (full_path.extension() != ".cus")
 		return;
 
-	CusFile file;
-	file.path_relative_to_customizing_directory = std::filesystem::relative(full_path, customizing_directory);
-
-	for (auto& [region, vec] : region_files_map) {
-		auto it = std::remove_if(vec.begin(), vec.end(), [&](const std::unique_ptr<CusFile>& f) {
-			return f->path_relative_to_customizing_directory == file.path_relative_to_customizing_directory;
-		});
-		if (it != vec.end()) {
-			vec.erase(it, vec.end());
-		}
+	const auto          rel_path = std::filesystem::relative(full_path, customizing_directory);
+	FileInfo            info;
+	PresetHeader::Bytes header;
+	std::string         region;
+	if (!ReadHeader(full_path, info, header, contents) || !LoadRegion(rel_path, header, region)) {
+		std::lock_guard<std::mutex> lock(file_mutex);
+		file_store.Erase(rel_path); // No longer loadable, drop what was loaded before
+		return;
 	}
 
-	std::ifstream f(full_path, std::ios::binary);
-	if (!f.is_open())
-		return;
+	std::lock_guard<std::mutex> lock(file_mutex);
+	CusFile*                    file = file_store.Insert(rel_path).first;
+	file_store.SetInfo(file, info);
+	file_store.SetRegion(file, region);
+}
 
-	f.seekg(0, std::ios::end);
-	size_t size = f.tellg();
-	if (size < 0x0B)
+void CusManager::RemoveFile(const std::filesystem::path& full_path) {
+	std::lock_guard<std::mutex> lock(file_mutex);
+	file_store.Erase(std::filesystem::relative(full_path, customizing_directory));
+}
+
+void CusManager::RenameFile(const std::filesystem::path& old_full_path, const std::filesystem::path& new_full_path) {
+	if (new_full_path.extension() != ".cus") {
+		RemoveFile(old_full_path);
 		return;
+	}
 
-	f.seekg(0, std::ios::beg);
-	file.data.resize(size);
-	f.read(file.data.data(), size);
-	f.close();
+	// The monitor only reports a rename when the contents are unchanged, so the loaded entry moves without a re-read
+	const auto old_rel_path = std::filesystem::relative(old_full_path, customizing_directory);
+	const auto new_rel_path = std::filesystem::relative(new_full_path, customizing_directory);
 
-	if (!LoadRegion(file))
+	std::unique_lock<std::mutex> lock(file_mutex);
+	CusFile*                     file = file_store.Find(old_rel_path);
+	if (!file) {
+		lock.unlock();
+		LoadFile(new_full_path); // Never loaded under the old path, so read it now
 		return;
+	}
 
-	auto& vec = region_files_map[file.region];
-	for (const auto& existing : vec) {
-		if (existing->path_relative_to_customizing_directory == file.path_relative_to_customizing_directory)
-			return; // Already present
+	if (new_rel_path != old_rel_path) {
+		file_store.Erase(new_rel_path); // Renamed over an existing preset
+		file_store.Rename(file, new_rel_path);
 	}
 
-	vec.emplace_back(std::make_unique<CusFile>(std::move(file)));
+	std::error_code error;
+	FileInfo        info = FileInfo::ReadMetadata(new_full_path, error);
+	if (!error) {
+		info.content_hash = file->info.content_hash;
+		file_store.SetInfo(file, info);
+	}
 }
 
-void CusManager::RemoveFile(const std::filesystem::path& full_path) {
-	auto rel_path = std::filesystem::relative(full_path, customizing_directory);
+void CusManager::RefreshUnconvertedFiles(const std::string& selected_region) {
+	// Never waits on a writer, whatever batch the monitor or a conversion is in the middle of
+	preset_model->Update(file_store.GetSnapshot());
 
-	for (auto& [region, vec] : region_files_map) {
-		auto it = std::remove_if(vec.begin(), vec.end(), [&](const std::unique_ptr<CusFile>& f) {
-			return f->path_relative_to_customizing_directory == rel_path;
-		});
-		if (it != vec.end()) {
-			vec.erase(it, vec.end());
-			break;
-		}
+	auto it = unconverted_views.find(selected_region);
+	if (it != unconverted_views.end() && it->second != shown_view) {
+		shown_view = it->second;
+		ui_handle->global<GlobalVariables>().set_unconverted_files(shown_view);
 	}
 }
 
-void CusManager::RefreshUnconvertedFiles(const std::string& excluded_region) const {
-	auto it = slint_models_by_excluded_region.find(excluded_region);
-	if (it != slint_models_by_excluded_region.end()) {
-		it->second->clear();
+std::shared_ptr<PresetRegionView> CusManager::GetSlintModelFiles(const std::string& excluded_region) {
+	return unconverted_views.at(excluded_region);
+}
 
-		for (const std::string& region : available_regions) {
-			if (region == excluded_region) {
-				continue;
-			}
+std::filesystem::path CusManager::GetCustomizingDirectory() const {
+	return customizing_directory;
+}
 
-			auto region_iterator = region_files_map.find(region);
-			if (region_iterator != region_files_map.end()) {
-				for (const auto& file_ptr : region_iterator->second) {
-					it->second->push_back(SlintCusFile { .path = slint::SharedString(file_ptr->path_relative_to_customizing_directory.string()), .region = slint::SharedString(file_ptr->region), .data_size = static_cast<int>(file_ptr->data.size()), .invalid = file_ptr->invalid });
-				}
-			}
-		}
+std::shared_ptr<const CusFileSnapshot> CusManager::GetFiles() const {
+	return file_store.GetSnapshot();
+}
 
-		if (excluded_region == "USA") {
-			ui_handle->global<GlobalVariables>().set_files_excluding_USA(it->second);
-		} else if (excluded_region == "KOR") {
-			ui_handle->global<GlobalVariables>().set_files_excluding_KOR(it->second);
-		} else if (excluded_region == "RUS") {
-			ui_handle->global<GlobalVariables>().set_files_excluding_RUS(it->second);
+void CusManager::RequestConversion(const std::string& region_name, ConversionCallback on_converted) {
+	conversion_service->Request(region_name, [this, on_converted = std::move(on_converted)](ConversionService::Outcome outcome) {
+		// A job that ran reports on the conversion thread before the next one starts, so conversion_result is still its own.
+		// A superseded one never ran and reports from the requesting thread, the result there belongs to another job.
+		ConversionResult result;
+		if (outcome != ConversionService::Outcome::SUPERSEDED) {
+			result = std::move(conversion_result);
 		}
-	}
-}
+		result.outcome = outcome;
 
-std::shared_ptr<slint::VectorModel<SlintCusFile>> CusManager::GetSlintModelFiles(const std::string& excluded_region) {
-	return slint_models_by_excluded_region.at(excluded_region);
+		ui_updates.Push({ .on_applied = [this, on_converted, result = std::move(result)]() {
+			if (result.outcome == ConversionService::Outcome::CONVERTED) {
+				PublishConversionResult(result);
+			}
+			if (on_converted) {
+				on_converted(result);
+			}
+		} });
+	});
 }
 
-std::filesystem::path CusManager::GetCustomizingDirectory() const {
-	return customizing_directory;
+UiUpdateQueue::Statistics CusManager::GetUiUpdateStatistics() const {
+	return ui_updates.GetStatistics();
 }
 
-const std::unordered_map<std::string, std::vector<std::unique_ptr<CusFile>>>& CusManager::GetFiles() const {
-	return region_files_map;
+void CusManager::ApplyUiUpdates(std::vector<UiUpdateQueue::Update>& updates) {
+	// Whatever was pushed, the newest snapshot already holds all of it, one refresh covers the lot
+	const std::string region = GetSelectedRegionSafe();
+	RefreshUnconvertedFiles(region);
+
+	const bool files_changed = std::ranges::any_of(updates, &UiUpdateQueue::Update::convert);
+	if (files_changed && automatic_conversion_enabled.load()) {
+		RequestConversion(region);
+	}
+
+	for (const UiUpdateQueue::Update& update : updates) {
+		if (update.on_applied) {
+			update.on_applied();
+		}
+	}
 }
 
-bool CusManager::ConvertFilesToRegion(const std::string& region_name) {
+bool CusManager::ConvertFilesToRegion(const std::string& region_name, const std::atomic<bool>& cancelled, ConversionResult& result) {
 	if (region_name.length() != 3) {
 		DEBUG_LOG("Region name must be exactly 3 characters.");
 		return false;
 	}
 
-	std::vector<CusFile*> files_to_save;
+	using Clock                                  = std::chrono::steady_clock;
+	result                                       = {};
+	RegionConverter::Statistics&      statistics = result.statistics;
+	std::vector<RegionConverter::Job> jobs;
 
+	// Plan: everything outside the target region, taken from the published snapshot so planning never waits on the monitor
+	Clock::time_point                            stage_start = Clock::now();
+	const std::shared_ptr<const CusFileSnapshot> snapshot    = file_store.GetSnapshot();
 	for (const std::string& region : available_regions) {
-		if (region == region_name) {
+		const CusFileSnapshot::Region* files = region == region_name ? nullptr : snapshot->FindRegion(region);
+		if (!files) {
 			continue;
 		}
 
-		auto region_iterator = region_files_map.find(region);
-		if (region_iterator != region_files_map.end()) {
-			auto& source_vector = region_iterator->second;
-			for (auto file_iterator = source_vector.rbegin(); file_iterator != source_vector.rend();) {
-				CusFile* file = file_iterator->get();
+		files->ForEach([&](const CusFileSnapshot::File& file) {
+			if (file.info.size < PresetHeader::SIZE) {
+				result.failures.push_back({ file.relative_path, "file is shorter than the preset header" });
+				return;
+			}
 
-				if (file->data.size() < 0x0B) {
-					DEBUG_LOG("Skipping incomplete file during conversion: " << file->path_relative_to_customizing_directory);
-					++file_iterator;
-					continue;
+			RegionConverter::Job& job = jobs.emplace_back();
+			job.relative_path         = file.relative_path;
+			job.full_path             = customizing_directory / file.relative_path;
+			job.expected              = file.info;
+		});
+	}
+	statistics.planned   = jobs.size();
+	statistics.plan_time = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - stage_start);
+
+	// Patch and write, the only stage that touches the disk
+	stage_start = Clock::now();
+	region_converter->Write(jobs, region_name, cancelled);
+	statistics.write_time = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - stage_start);
+
+	// Record: move the written files and remember them as our own writes, under one lock for the batch
+	stage_start           = Clock::now();
+	{
+		std::lock_guard<std::mutex> lock(file_mutex);
+		for (RegionConverter::Job& job : jobs) {
+			switch (job.status) {
+			case PresetHeader::WriteStatus::WRITTEN:
+				statistics.written++;
+				// Removed or reloaded by the monitor while the batch was written, the store already holds the newer state
+				if (CusFile* file = file_store.Find(job.relative_path); file && file->info.HasSameMetadata(job.expected)) {
+					file_store.SetRegion(file, region_name);
+					file_store.SetInfo(file, job.written); // The new hash is unknown without reading the file, the monitor's next report carries it
+					self_writes.Expect(job.canonical_path, job.written);
 				}
-
-				auto file_ptr        = std::move(*file_iterator);
-				file_iterator        = std::reverse_iterator(source_vector.erase(std::next(file_iterator).base()));
-
-				file_ptr->region     = region_name;
-				file_ptr->data[0x08] = region_name[0];
-				file_ptr->data[0x09] = region_name[1];
-				file_ptr->data[0x0A] = region_name[2];
-
-				files_to_save.push_back(file_ptr.get());
-				region_files_map[region_name].push_back(std::move(file_ptr));
+				break;
+			case PresetHeader::WriteStatus::FILE_CHANGED:
+				// Left in its region, the monitor reports whatever changed the file
+				result.failures.push_back({ std::move(job.relative_path), "file changed since it was loaded" });
+				statistics.changed++;
+				break;
+			case PresetHeader::WriteStatus::FAILED:
+				if (job.error == std::errc::operation_canceled) {
+					statistics.cancelled++;
+					break;
+				}
+				result.failures.push_back({ std::move(job.relative_path), job.error.message() });
+				statistics.failed++;
+				break;
 			}
 		}
+		file_store.Publish();
 	}
+	statistics.record_time = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - stage_start);
 
-	return SaveFilesToDisk(files_to_save);
+	for (const ConversionFailure& failure : result.failures) {
+		DEBUG_LOG("Skipping " << failure.relative_path << " during conversion: " << failure.reason);
+	}
+	if (statistics.cancelled > 0) {
+		DEBUG_LOG("Conversion to " << region_name << " cancelled with " << statistics.cancelled << " files left.");
+	}
+	DEBUG_LOG("Saved " << statistics.written << " of " << statistics.planned << " files to disk with " << region_converter->GetConcurrency() << " writers"
+	                   << " (plan " << statistics.plan_time.count() << " us, write " << statistics.write_time.count() << " us at "
+	                   << static_cast<uint64_t>(statistics.FilesPerSecond(statistics.write_time)) << " files/s, record " << statistics.record_time.count() << " us).");
+	return statistics.cancelled == 0; // Finished unless cancelled skipped some files
 }
 
-bool CusManager::LoadRegion(CusFile& file) const {
-	file.region += static_cast<char>(static_cast<unsigned char>(file.data[0x08]));
-	file.region += static_cast<char>(static_cast<unsigned char>(file.data[0x09]));
-	file.region += static_cast<char>(static_cast<unsigned char>(file.data[0x0A]));
+bool CusManager::LoadRegion(const std::filesystem::path& relative_path, const PresetHeader::Bytes& header, std::string& region) const {
+	region.assign(header.data() + PresetHeader::REGION_OFFSET, PresetHeader::REGION_LENGTH);
 
-	if (!available_regions.contains(file.region)) {
-		file.invalid = true;
-		DEBUG_LOG("Warning: Invalid region '" << file.region << "' in " << file.path_relative_to_customizing_directory);
+	if (!IsAvailableRegion(region)) {
+		DEBUG_LOG("Warning: Invalid region '" << region << "' in " << relative_path);
 		return false;
 	}
 
@@ -195,77 +293,56 @@ void CusManager::StartMonitorThread() {
 				break;
 
 			lock.unlock();
+			self_writes.ExpireOld();
 
 			auto changes = directory_monitor->CheckForDirectoryChanges();
+			{
+				std::lock_guard<std::mutex> statistics_lock(monitor_statistics_mutex);
+				monitor_backend         = directory_monitor->GetBackendName(); // Changes if the monitor fell back to polling
+				monitored_files         = directory_monitor->GetFileCount();
+				monitor_scan_statistics = directory_monitor->GetLastScanStatistics();
+			}
 			if (!changes.empty()) {
-				// Step 1: Coalesce changes by canonical path
-				struct CanonicalChange {
-					DirectoryMonitor::ChangeInfo::Type type;
-					fs::path                                 original_path;
-					fs::path                                 new_path;
-				};
-
-				std::unordered_map<fs::path, CanonicalChange> coalesced_changes;
-
-				for (const auto& change : changes) {
-					fs::path canonical_path;
-					try {
-						canonical_path = fs::weakly_canonical(change.path);
-					} catch (...) {
-						canonical_path = change.path; // fallback to original
-					}
+				const uint64_t bytes_read_before = bytes_read.load();
 
-					coalesced_changes[canonical_path] = CanonicalChange {
-						change.type, change.old_path, change.path
-					};
-				}
+				// Step 1: Resolve the batch, renames stay in order and additions and modifications are coalesced by canonical path
+				const ChangeBatch batch(changes);
 
-				// Step 2: Apply deletions first to ensure clean state
-				for (const auto& [canonical_path, change] : coalesced_changes) {
-					if (change.type == DirectoryMonitor::ChangeInfo::DELETED ||
-					    change.type == DirectoryMonitor::ChangeInfo::RENAMED) {
-						RemoveFile(change.original_path);
+				// Step 2: Apply deletions and renames in the order they happened. Renames move the loaded entry, nothing is re-read.
+				for (const auto& change : batch.GetMoves()) {
+					if (change.type == DirectoryMonitor::ChangeInfo::DELETED) {
+						RemoveFile(change.path);
+					} else {
+						RenameFile(change.old_path, change.path);
 					}
 				}
 
 				// Step 3: Apply additions and modifications
-				for (const auto& [canonical_path, change] : coalesced_changes) {
-					bool skip = false;
-					{
-						std::lock_guard<std::mutex> recent_lock(recently_modified_mutex);
-						if (recently_modified_paths.contains(canonical_path)) {
-							recently_modified_paths.erase(canonical_path);
-							skip = true;
+				for (const auto& [canonical_path, load] : batch.GetLoads()) {
+					// Ours only if the file is still exactly as our conversion left it, anything written since is reloaded
+					const FileInfo current    = load.contents ? load.contents->info : FileInfo::ReadMetadata(load.path);
+					const uint64_t generation = self_writes.Match(canonical_path, current);
+					if (generation != 0) {
+						// Nothing to reload, but the monitor hashed the result
+						if (load.contents) {
+							AdoptWrittenHash(load.path, load.contents->info);
 						}
+						continue;
 					}
 
-					if (skip)
-						continue;
+					LoadFile(load.path, load.contents.get());
+				}
 
-					switch (change.type) {
-						case DirectoryMonitor::ChangeInfo::ADDED:
-						case DirectoryMonitor::ChangeInfo::MODIFIED:
-							LoadFile(change.new_path);
-							break;
-						case DirectoryMonitor::ChangeInfo::RENAMED:
-							LoadFile(change.new_path);
-							break;
-						default:
-							break;
-					}
+				// One new version for the whole batch, readers keep the previous one until then
+				{
+					std::lock_guard<std::mutex> store_lock(file_mutex);
+					file_store.Publish();
 				}
 
-				// Step 4: Refresh file list & trigger auto-conversion
-				std::string region_copy = GetSelectedRegionSafe();
-				slint::invoke_from_event_loop([this, region_copy]() {
-					std::lock_guard<std::mutex> lock(conversion_mutex);
-					RefreshUnconvertedFiles(region_copy);
-					if (automatic_conversion_enabled.load()) {
-						if (ConvertFilesToRegion(region_copy)) {
-							DEBUG_LOG("Converted files to region: " << region_copy);
-						}
-					}
-				});
+				DEBUG_LOG("Applied " << changes.size() << " changes, read " << (bytes_read.load() - bytes_read_before) << " bytes (" << FileInfo::GetBytesRead() << " hashed by the monitor so far).");
+
+				// Step 4: Hand the batch to the UI, which refreshes and converts once for everything pushed since its last frame
+				ui_updates.Push({ .changes = changes.size(), .convert = true, .on_applied = nullptr });
 			}
 
 			lock.lock();
@@ -283,67 +360,189 @@ void CusManager::StopMonitorThread() {
 	}
 }
 
+/* One enumerated preset, filled by a load worker and merged into the store by the calling thread */
+struct CusManager::LoadedFile {
+	enum class Outcome {
+		RESTORED,       // Unchanged since the snapshot index was written, taken from it without a read
+		READ,
+		UNREADABLE,
+		INVALID_REGION
+	};
+
+	std::filesystem::path       full_path;
+	std::filesystem::path       relative_path;
+	const SnapshotIndex::Entry* indexed = nullptr;
+	FileInfo                    info;
+	std::string                 region;
+	Outcome                     outcome = Outcome::UNREADABLE;
+};
+
 bool CusManager::LoadFilesFromDisk() {
+	files_loaded_time       = std::chrono::file_clock::now();
+	const bool index_loaded = snapshot_index->Load(customizing_directory);
+
 	try {
+		// Enumerate once, the order of this list is the order files join the store whatever the thread count
+		std::vector<LoadedFile>         files;
+		std::unordered_set<std::string> seen_keys;
 		for (const auto& entry : std::filesystem::recursive_directory_iterator(customizing_directory)) {
 			if (entry.is_regular_file() && entry.path().extension() == ".cus") {
-				CusFile file;
-				file.path_relative_to_customizing_directory = std::filesystem::relative(entry.path(), customizing_directory);
+				LoadedFile& file   = files.emplace_back();
+				file.full_path     = entry.path();
+				file.relative_path = std::filesystem::relative(entry.path(), customizing_directory);
+
+				if (index_loaded) {
+					std::string key = SnapshotIndex::MakeKey(file.relative_path);
+					file.indexed    = snapshot_index->Find(key);
+					seen_keys.insert(std::move(key));
+				}
+			}
+		}
 
-				std::ifstream f(entry.path(), std::ios::binary);
-				if (!f.is_open())
-					continue;
+		// Read headers on the workers, each pulling the next file so no more than one read per worker is in flight
+		const unsigned thread_count = std::min<size_t>(ThreadPool::ResolveThreadCount(scan_options.thread_count), std::max<size_t>(files.size() / LOAD_FILES_PER_THREAD, 1));
+		if (thread_count <= 1) {
+			for (LoadedFile& file : files) {
+				LoadHeader(file);
+			}
+		} else {
+			ThreadPool          pool(thread_count);
+			std::atomic<size_t> next_file = 0;
+			for (unsigned worker = 0; worker < thread_count; ++worker) {
+				pool.Submit([this, &files, &next_file]() {
+					for (size_t index; (index = next_file.fetch_add(1, std::memory_order_relaxed)) < files.size();) {
+						LoadHeader(files[index]);
+					}
+				});
+			}
+			pool.WaitIdle();
+		}
 
-				f.seekg(0, std::ios::end);
-				size_t size = f.tellg();
-				f.seekg(0, std::ios::beg);
+		// Merge in enumeration order, the only pass that touches the store
+		size_t restored_count       = 0;
+		size_t offline_change_count = 0; // Added, modified or deleted while the application was closed
+		for (LoadedFile& file : files) {
+			if (file.outcome == LoadedFile::Outcome::UNREADABLE)
+				continue;
 
-				if (size < 0x0B)
-					continue;
+			if (file.outcome == LoadedFile::Outcome::RESTORED) {
+				restored_count++;
+			} else if (index_loaded) {
+				offline_change_count++; // Not in the index, or its metadata moved since it was saved
+			}
 
-				file.data.resize(size);
-				f.read(file.data.data(), size);
-				f.close();
+			if (file.outcome == LoadedFile::Outcome::INVALID_REGION) {
+				DEBUG_LOG("Warning: Invalid region '" << file.region << "' in " << file.relative_path);
+				continue;
+			}
 
-				if (!LoadRegion(file))
-					continue;
+			CusFile* loaded = file_store.Insert(file.relative_path).first;
+			file_store.SetInfo(loaded, file.info);
+			file_store.SetRegion(loaded, file.region);
+		}
+		file_store.Publish();
 
-				region_files_map[file.region].emplace_back(std::make_unique<CusFile>(std::move(file)));
+		if (index_loaded) {
+			for (const auto& [key, indexed] : snapshot_index->GetEntries()) {
+				if (!seen_keys.contains(std::string(key))) {
+					offline_change_count++;
+				}
 			}
+
+			DEBUG_LOG("Restored " << restored_count << " files from the snapshot index, " << offline_change_count << " changed while closed.");
 		}
+		DEBUG_LOG("Loaded " << file_store.Size() << " of " << files.size() << " presets with " << thread_count << " threads.");
 
-		return !region_files_map.empty();
+		snapshot_index->Release();
+		return file_store.Size() > 0;
 	} catch (const std::exception& e) {
 		DEBUG_LOG("Error loading files: " << e.what());
+		snapshot_index->Release();
 		return false;
 	}
 }
 
-bool CusManager::SaveFilesToDisk(const std::vector<CusFile*>& modified_files) {
-	int saved = 0;
+void CusManager::LoadHeader(LoadedFile& file) const {
+	// Stat-only fast path: an unchanged file is restored from the index without being read
+	if (file.indexed) {
+		file.info = FileInfo::ReadMetadata(file.full_path);
+		if (snapshot_index->IsUnchanged(*file.indexed, file.info)) {
+			file.region.assign(file.indexed->region, sizeof(file.indexed->region));
+			if (IsAvailableRegion(file.region)) {
+				file.info.content_hash = file.indexed->content_hash;
+				file.outcome           = LoadedFile::Outcome::RESTORED;
+				return;
+			}
+		}
+	}
 
-	for (const CusFile* file : modified_files) {
-		std::filesystem::path file_write_out_path = customizing_directory / file->path_relative_to_customizing_directory;
+	PresetHeader::Bytes header;
+	if (!ReadHeader(file.full_path, file.info, header)) {
+		file.outcome = LoadedFile::Outcome::UNREADABLE;
+		return;
+	}
 
-		if (!std::filesystem::exists(file_write_out_path)) {
-			DEBUG_LOG("Skipping write: file was deleted -> " << file_write_out_path);
-			continue;
-		}
+	file.region.assign(header.data() + PresetHeader::REGION_OFFSET, PresetHeader::REGION_LENGTH);
+	file.outcome = IsAvailableRegion(file.region) ? LoadedFile::Outcome::READ : LoadedFile::Outcome::INVALID_REGION;
+}
+
+bool CusManager::ReadHeader(const std::filesystem::path& full_path, FileInfo& info, PresetHeader::Bytes& header, const DirectoryMonitor::FileContents* contents) const {
+	if (contents) {
+		// Already read and hashed by the monitor
+		if (contents->data.size() < PresetHeader::SIZE)
+			return false;
+
+		std::copy_n(contents->data.begin(), PresetHeader::SIZE, header.begin());
+		info = contents->info;
+		return true;
+	}
+
+	info = FileInfo::ReadMetadata(full_path); // Before reading, so a write racing the read leaves the metadata stale rather than the hash
+	if (info.size < PresetHeader::SIZE || !PresetHeader::Read(full_path, header))
+		return false;
+
+	bytes_read.fetch_add(PresetHeader::SIZE, std::memory_order_relaxed);
+
+	// Only the header is read, the hash stays unknown until the monitor reports the file with one
+	return true;
+}
+
+DirectoryMonitor::Seed CusManager::BuildMonitorSeed() const {
+	DirectoryMonitor::Seed seed;
+	seed.hashed_since = files_loaded_time;
+
+	file_store.ForEach([&](const CusFile& file) {
+		seed.files.emplace(customizing_directory / file.GetRelativePath(), file.info);
+	});
+
+	return seed;
+}
 
-		std::ofstream f(file_write_out_path, std::ios::binary);
-		f.write(file->data.data(), file->data.size());
-		f.close();
+void CusManager::SaveSnapshotIndex() const {
+	std::vector<std::pair<std::string, SnapshotIndex::Entry>> entries;
 
-		{
-			std::lock_guard<std::mutex> lock(recently_modified_mutex);
-			recently_modified_paths.insert(std::filesystem::weakly_canonical(file_write_out_path));
+	entries.reserve(file_store.Size());
+	file_store.ForEach([&](const CusFile& file) {
+		if (file.info.file_id != 0) {
+			entries.emplace_back(SnapshotIndex::MakeKey(file.GetRelativePath()), SnapshotIndex::MakeEntry(file.info, file.region));
 		}
+	});
+
+	snapshot_index->Save(customizing_directory, entries);
+}
 
-		saved++;
+void CusManager::AdoptWrittenHash(const std::filesystem::path& full_path, const FileInfo& info) {
+	std::lock_guard<std::mutex> lock(file_mutex);
+	CusFile*                    file = file_store.Find(std::filesystem::relative(full_path, customizing_directory));
+	if (file && file->info.HasSameMetadata(info)) {
+		FileInfo hashed     = file->info;
+		hashed.content_hash = info.content_hash;
+		file_store.SetInfo(file, hashed);
 	}
+}
 
-	DEBUG_LOG("Saved " << saved << " modified files to disk.");
-	return true;
+bool CusManager::IsAvailableRegion(std::string_view region) const {
+	return std::ranges::find(available_regions, region) != available_regions.end();
 }
 
 void CusManager::SetSelectedRegionSafe(const std::string& region) {
@@ -356,6 +555,10 @@ std::string CusManager::GetSelectedRegionSafe() {
 	return selected_region;
 }
 
+uint64_t CusManager::GetBytesRead() const {
+	return bytes_read.load(std::memory_order_relaxed);
+}
+
 bool CusManager::GetAutomaticConversionEnabled() const {
 	return automatic_conversion_enabled.load();
 }
@@ -363,3 +566,53 @@ bool CusManager::GetAutomaticConversionEnabled() const {
 void CusManager::SetAutomaticConversionEnabled(bool enabled) {
 	automatic_conversion_enabled.store(enabled);
 }
+
+void CusManager::PublishConversionProgress() {
+	const bool converting = conversion_service->IsBusy();
+	if (!converting && !progress_published)
+		return; // Idle and already shown as idle
+
+	const RegionConverter::Progress progress = region_converter->GetProgress();
+	GlobalVariables&                globals  = ui_handle->global<GlobalVariables>();
+	globals.set_converting(converting);
+	globals.set_conversion_files_done(static_cast<int>(progress.done));
+	globals.set_conversion_files_total(static_cast<int>(progress.total));
+	globals.set_conversion_files_per_second(static_cast<int>(progress.files_per_second));
+	progress_published = converting;
+}
+
+void CusManager::PublishConversionResult(const ConversionResult& result) {
+	GlobalVariables& globals = ui_handle->global<GlobalVariables>();
+	globals.set_conversion_files_written(static_cast<int>(result.statistics.written));
+	globals.set_conversion_files_failed(static_cast<int>(result.failures.size()));
+
+	// The first one is enough to act on, the rest are in the debug log
+	std::string first_failure;
+	if (!result.failures.empty()) {
+		first_failure = result.failures.front().relative_path.generic_string() + ": " + result.failures.front().reason;
+	}
+	globals.set_conversion_failure(slint::SharedString(first_failure));
+}
+
+void CusManager::PublishDiagnostics() {
+	std::unique_lock<std::mutex>           lock(monitor_statistics_mutex);
+	const slint::SharedString              backend(monitor_backend);
+	const size_t                           files      = monitored_files;
+	const DirectoryMonitor::ScanStatistics statistics = monitor_scan_statistics;
+	lock.unlock();
+
+	GlobalVariables& globals = ui_handle->global<GlobalVariables>();
+	globals.set_monitor_backend(backend);
+	globals.set_monitored_files(static_cast<int>(files));
+	globals.set_scan_hashes_computed(static_cast<int>(statistics.hashes_computed));
+	globals.set_scan_hashes_skipped(static_cast<int>(statistics.hashes_skipped));
+	globals.set_scan_directories_listed(static_cast<int>(statistics.directories_listed));
+	globals.set_scan_directories_pruned(static_cast<int>(statistics.directories_pruned));
+
+	// Already atomic, read here rather than recorded by the monitor thread
+	const UiUpdateQueue::Statistics ui_statistics = GetUiUpdateStatistics();
+	globals.set_ui_refreshes_per_second(static_cast<int>(ui_statistics.refreshes_per_second));
+	globals.set_ui_queue_depth(static_cast<int>(ui_statistics.queue_depth));
+	globals.set_ui_peak_queue_depth(static_cast<int>(ui_statistics.peak_queue_depth));
+	globals.set_ui_updates_coalesced(static_cast<int>(ui_statistics.pushed - ui_statistics.posted));
+}
\ No newline at end of file
@@ -1,45 +1,67 @@
 #ifndef CUSMANAGER_H_
 #define CUSMANAGER_H_
 
+#include "ConversionService.h"
+#include "CusFileStore.h"
+#include "DirectoryMonitor.h"
+#include "FileInfo.h"
+#include "PresetHeader.h"
+#include "PresetListModel.h"
+#include "PresetRegionView.h"
+#include "RegionConverter.h"
+#include "SelfWriteTokens.h"
+#include "UiUpdateQueue.h"
+
 #include <app-window.h>
 #include <filesystem>
+#include <functional>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
-class DirectoryMonitor;
+class SnapshotIndex;
 class SlintCusFile;
 
-struct CusFile {
-	std::filesystem::path path_relative_to_customizing_directory;
-	std::vector<char>     data;
-	std::string           region;
-	bool                  invalid = false;
-};
-
 class CusManager {
 public:
+	struct ConversionFailure {
+		std::filesystem::path relative_path;
+		std::string           reason;
+	};
+
+	/* What one conversion did, handed to on_converted by value. Only a CONVERTED one is complete, a CANCELLED one holds what
+	 * it did before it stopped and a SUPERSEDED one is empty. */
+	struct ConversionResult {
+		ConversionService::Outcome     outcome = ConversionService::Outcome::CONVERTED;
+		std::vector<ConversionFailure> failures;
+		RegionConverter::Statistics    statistics;
+	};
+	using ConversionCallback = std::function<void(const ConversionResult& result)>;
+
 	explicit CusManager(slint::ComponentHandle<AppWindow> ui);
 	~CusManager();
-	void                                                                                        LoadFile(const std::filesystem::path& full_path);
+	void                                                                                        LoadFile(const std::filesystem::path& full_path, const DirectoryMonitor::FileContents* contents = nullptr);
 	void                                                                                        RemoveFile(const std::filesystem::path& full_path);
+	void                                                                                        RenameFile(const std::filesystem::path& old_full_path, const std::filesystem::path& new_full_path);
 
-	void                                                                                        RefreshUnconvertedFiles(const std::string& excluded_region) const;
-	std::shared_ptr<slint::VectorModel<SlintCusFile>>                                           GetSlintModelFiles(const std::string& excluded_region);
+	void                                                                                        RefreshUnconvertedFiles(const std::string& selected_region); // UI thread only
+	std::shared_ptr<PresetRegionView>                                                           GetSlintModelFiles(const std::string& excluded_region);
 
 	std::filesystem::path                                                                       GetCustomizingDirectory() const;
 
-	[[nodiscard]] const std::unordered_map<std::string, std::vector<std::unique_ptr<CusFile>>>& GetFiles() const;
-	[[nodiscard]] bool                                                                          ConvertFilesToRegion(const std::string& region_name);
+	[[nodiscard]] std::shared_ptr<const CusFileSnapshot>                                        GetFiles() const; // As last published, never blocks
+	// Converts on the conversion thread, superseding a conversion to another region. on_converted runs on the UI thread after the file list is refreshed, once for every request, superseded or cancelled ones included.
+	void                                                                                        RequestConversion(const std::string& region_name, ConversionCallback on_converted = {});
+	[[nodiscard]] UiUpdateQueue::Statistics                                                     GetUiUpdateStatistics() const;
 
-	bool                                                                                        SaveFilesToDisk(const std::vector<CusFile*>& modified_files);
 	void                                                                                        SetSelectedRegionSafe(const std::string& region);
 	std::string                                                                                 GetSelectedRegionSafe();
 	bool                                                                                        GetAutomaticConversionEnabled() const;
+	[[nodiscard]] uint64_t                                                                      GetBytesRead() const; // Header bytes read from disk, hashing passes count in FileInfo::GetBytesRead
 
 	void                                                                                        SetAutomaticConversionEnabled(bool enabled);
 
-	std::mutex                                                                                  conversion_mutex;
-
 private:
 	slint::ComponentHandle<AppWindow>                                                  ui_handle;
 
@@ -48,26 +70,62 @@ private:
 	std::atomic<bool>                                                                  automatic_conversion_enabled = false;
 	std::condition_variable                                                            monitor_condition_variable;
 	std::atomic<bool>                                                                  active            = true;
+	mutable std::atomic<uint64_t>                                                      bytes_read        = 0;
 
-	const std::unordered_set<std::string>                                              available_regions = { "USA", "KOR", "RUS" };
+	const std::vector<std::string>                                                     available_regions = { "USA", "KOR", "RUS" }; // In the order the UI shows them
 	std::string                                                                        selected_region;
 	std::mutex                                                                         selected_region_mutex;
-	std::mutex                                                                         file_mutex;
+	std::mutex                                                                         file_mutex; // Serializes the monitor and conversion threads writing file_store, readers use its snapshots
 	std::mutex                                                                         monitor_mutex;
 
-	std::mutex                                                                         recently_modified_mutex;
-	std::unordered_set<std::filesystem::path>                                          recently_modified_paths;
+	SelfWriteTokens                                                                    self_writes { SELF_WRITE_LIFETIME };
 
 	std::filesystem::path                                                              customizing_directory;
+	DirectoryScanOptions                                                               scan_options; // thread_count also sizes the cold load
 	std::unique_ptr<DirectoryMonitor>                                                  directory_monitor;
-
-	std::unordered_map<std::string, std::shared_ptr<slint::VectorModel<SlintCusFile>>> slint_models_by_excluded_region;
-	std::unordered_map<std::string, std::vector<std::unique_ptr<CusFile>>>             region_files_map;
+	std::unique_ptr<SnapshotIndex>                                                     snapshot_index;
+	std::unique_ptr<RegionConverter>                                                   region_converter;
+	std::unique_ptr<ConversionService>                                                 conversion_service;
+	slint::Timer                                                                       progress_timer;
+	slint::Timer                                                                       diagnostics_timer;
+	std::mutex                                                                         monitor_statistics_mutex; // The monitor thread records, the UI thread reads
+	const char*                                                                        monitor_backend = "";
+	size_t                                                                             monitored_files = 0;
+	DirectoryMonitor::ScanStatistics                                                   monitor_scan_statistics;
+	bool                                                                               progress_published = false;
+	ConversionResult                                                                   conversion_result; // Conversion thread only, moved out once the conversion finishes
+	std::chrono::time_point<std::chrono::file_clock>                                   files_loaded_time;
+
+	std::shared_ptr<PresetListModel>                                                   preset_model; // Every preset, grouped by region
+	std::unordered_map<std::string, std::shared_ptr<PresetRegionView>>                 unconverted_views;
+	std::shared_ptr<PresetRegionView>                                                  shown_view;
+	UiUpdateQueue                                                                      ui_updates; // Every refresh reaches the UI through here, coalesced per frame
+	CusFileStore                                                                       file_store;
 
 	void                                                                               StartMonitorThread();
 	void                                                                               StopMonitorThread();
+	struct LoadedFile;
+	static constexpr size_t                                                            LOAD_FILES_PER_THREAD = 64; // Fewer files than this per worker are not worth a thread
+
+	static constexpr std::chrono::milliseconds                                         PROGRESS_INTERVAL { 100 };
+	static constexpr std::chrono::milliseconds                                         DIAGNOSTICS_INTERVAL { 1000 };
+	static constexpr std::chrono::milliseconds                                         FRAME_INTERVAL { 16 };
+	static constexpr std::chrono::milliseconds                                         SELF_WRITE_LIFETIME { 30000 }; // Well past the write settle period, an expired token costs one reload
+
 	bool                                                                               LoadFilesFromDisk();
-	bool                                                                               LoadRegion(CusFile& file) const;
+	// A file that cannot be written is skipped and listed in result. Runs on the conversion thread.
+	[[nodiscard]] bool                                                                 ConvertFilesToRegion(const std::string& region_name, const std::atomic<bool>& cancelled, ConversionResult& result);
+	void                                                                               PublishConversionProgress();
+	void                                                                               PublishConversionResult(const ConversionResult& result); // UI thread
+	void                                                                               PublishDiagnostics();
+	void                                                                               ApplyUiUpdates(std::vector<UiUpdateQueue::Update>& updates); // UI thread
+	void                                                                               LoadHeader(LoadedFile& file) const; // Safe on any thread, never touches the store
+	[[nodiscard]] bool                                                                 IsAvailableRegion(std::string_view region) const;
+	bool                                                                               LoadRegion(const std::filesystem::path& relative_path, const PresetHeader::Bytes& header, std::string& region) const;
+	bool                                                                               ReadHeader(const std::filesystem::path& full_path, FileInfo& info, PresetHeader::Bytes& header, const DirectoryMonitor::FileContents* contents = nullptr) const;
+	void                                                                               AdoptWrittenHash(const std::filesystem::path& full_path, const FileInfo& info);
+	DirectoryMonitor::Seed                                                             BuildMonitorSeed() const;
+	void                                                                               SaveSnapshotIndex() const;
 };
 
 #endif /* CUSMANAGER_H_ */
\ No newline at end of file
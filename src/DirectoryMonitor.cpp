@@ -1,13 +1,13 @@
 #include "DirectoryMonitor.h"
 
 #include "Debug.h"
+#include "InotifyChangeSource.h"
+#include "PollingChangeSource.h"
+#include "WriteSettler.h"
 
-#include <fstream>
-#include <functional>
-#include <ranges>
 #include <stdexcept>
 #include <string>
-#include <thread>
+#include <unordered_set>
 
 std::string DirectoryMonitor::ChangeInfo::TypeToString() const {
 	switch (type) {
@@ -24,105 +24,90 @@ std::string DirectoryMonitor::ChangeInfo::TypeToString() const {
 	}
 }
 
-DirectoryMonitor::DirectoryMonitor(const std::filesystem::path& path, bool recurse_subdirectories)
-    : root_path(path), recurse_subdirectories(recurse_subdirectories), file_cache(ScanDirectory()) {
+DirectoryMonitor::DirectoryMonitor(const std::filesystem::path& path, bool recurse_subdirectories, Backend backend, DirectoryScanOptions scan_options, const Seed* seed)
+    : root_path(path), recurse_subdirectories(recurse_subdirectories), scan_options(scan_options) {
 	if (!fs::exists(root_path) || !fs::is_directory(root_path)) {
 		throw std::runtime_error("Invalid directory path: " + root_path.generic_string());
 	}
-}
 
-DirectoryMonitor::~DirectoryMonitor() {
+	change_source = CreateChangeSource(backend, seed);
+	write_settler = std::make_unique<WriteSettler>(scan_options.write_settle_period);
+	DEBUG_LOG("DirectoryMonitor using " << change_source->GetName() << " backend for " << root_path.generic_string());
 }
 
-size_t DirectoryMonitor::GetFileCount() const {
-	return file_cache.size();
+DirectoryMonitor::~DirectoryMonitor() {
 }
 
-std::vector<DirectoryMonitor::ChangeInfo> DirectoryMonitor::CheckForDirectoryChanges() {
-	std::vector<ChangeInfo>                changes;
-	auto                                   currentSnapshot = ScanDirectory();
-
-	// Maps for tracking renames via file_id
-	std::unordered_map<uint64_t, fs::path> old_id_to_path;
-	std::unordered_map<uint64_t, fs::path> new_id_to_path;
-
-	for (const auto& [path, info] : file_cache) {
-		if (info.file_id != 0) {
-			old_id_to_path[info.file_id] = path;
+std::unique_ptr<DirectoryMonitor::ChangeSource> DirectoryMonitor::CreateChangeSource(Backend backend, const Seed* seed) const {
+#ifdef __linux__
+	if (backend == Backend::AUTOMATIC || backend == Backend::INOTIFY) {
+		auto inotify_source = std::make_unique<InotifyChangeSource>(root_path, recurse_subdirectories);
+		if (inotify_source->IsValid()) {
+			return inotify_source;
 		}
-	}
 
-	for (const auto& [path, info] : currentSnapshot) {
-		if (info.file_id != 0) {
-			new_id_to_path[info.file_id] = path;
-		}
+		DEBUG_LOG("inotify unavailable, falling back to polling.");
+	}
+#else
+	if (backend == Backend::INOTIFY) {
+		DEBUG_LOG("inotify is only available on Linux, falling back to polling.");
 	}
+#endif
 
-	// Detect modified and renamed files
-	for (const auto& [file_id, new_path] : new_id_to_path) {
-		auto old_it = old_id_to_path.find(file_id);
-		if (old_it != old_id_to_path.end()) {
-			const auto& old_path = old_it->second;
+	return std::make_unique<PollingChangeSource>(root_path, recurse_subdirectories, scan_options, seed);
+}
 
-			const auto& old_info = file_cache.at(old_path);
-			const auto& new_info = currentSnapshot.at(new_path);
+void DirectoryMonitor::FallBackToPolling(std::vector<ChangeInfo>& changes) {
+	DEBUG_LOG(change_source->GetName() << " backend can no longer see every change, resynchronizing by polling.");
 
-			if (old_path != new_path) {
-				changes.push_back({ ChangeInfo::RENAMED, new_path, old_path });
-			} else if (old_info != new_info) {
-				changes.push_back({ ChangeInfo::MODIFIED, new_path });
-			}
-		} else {
-			changes.push_back({ ChangeInfo::ADDED, new_path });
-		}
+	// Whatever changed in the unseen part is only known by comparing the two file lists, so every file is reported once
+	const std::vector<fs::path> previous_files = change_source->GetKnownFiles();
+	change_source                              = std::make_unique<PollingChangeSource>(root_path, recurse_subdirectories, scan_options);
+
+	std::unordered_set<fs::path> current_files;
+	for (fs::path& file : change_source->GetKnownFiles()) {
+		current_files.insert(std::move(file));
 	}
 
-	// Detect deleted files
-	for (const auto& [file_id, old_path] : old_id_to_path) {
-		if (!new_id_to_path.contains(file_id)) {
-			changes.push_back({ ChangeInfo::DELETED, old_path });
+	for (const fs::path& file : previous_files) {
+		if (!current_files.contains(file)) {
+			changes.push_back({ ChangeInfo::DELETED, file, {}, nullptr });
 		}
 	}
+	for (const fs::path& file : current_files) {
+		changes.push_back({ ChangeInfo::MODIFIED, file, {}, nullptr });
+	}
+}
 
-	file_cache = std::move(currentSnapshot);
-	return changes;
+size_t DirectoryMonitor::GetFileCount() const {
+	return change_source->GetFileCount();
 }
 
-void DirectoryMonitor::ResetCache() {
-	file_cache = ScanDirectory();
-	DEBUG_LOG("DirectoryMonitor reset. Now tracking " << file_cache.size() << " items.");
+size_t DirectoryMonitor::GetPendingChangeCount() const {
+	return write_settler->GetPendingCount();
 }
 
-std::unordered_map<std::filesystem::path, FileInfo> DirectoryMonitor::ScanDirectory() const {
-	std::unordered_map<std::filesystem::path, FileInfo> current_files;
-
-	try {
-		auto process_entry = [&](const fs::directory_entry& entry) {
-			try {
-				if (entry.is_regular_file() && entry.path().extension() == ".cus") {
-					current_files[entry.path()] = FileInfo(entry.path());
-				}
-			} catch (const fs::filesystem_error& error) {
-				DEBUG_LOG(error.what());
-			}
-		};
-
-		if (recurse_subdirectories) {
-			for (const auto& entry : fs::recursive_directory_iterator(root_path, fs::directory_options::skip_permission_denied)) {
-				process_entry(entry);
-			}
-		} else {
-			for (const auto& entry : fs::directory_iterator(root_path, fs::directory_options::skip_permission_denied)) {
-				process_entry(entry);
-			}
-		}
-	} catch (const fs::filesystem_error& error) {
-		DEBUG_LOG(error.what());
-	}
+const char* DirectoryMonitor::GetBackendName() const {
+	return change_source->GetName();
+}
 
-	DEBUG_LOG("Scan complete. Cached " << file_cache.size() << " items.");
+DirectoryMonitor::ScanStatistics DirectoryMonitor::GetLastScanStatistics() const {
+	return change_source->GetLastScanStatistics();
+}
 
-	return current_files;
+std::vector<DirectoryMonitor::ChangeInfo> DirectoryMonitor::CheckForDirectoryChanges() {
+	auto changes = change_source->CollectChanges();
+	if (!change_source->IsValid()) {
+		FallBackToPolling(changes);
+	}
+	write_settler->Settle(changes);
+	return changes;
+}
+
+void DirectoryMonitor::ResetCache() {
+	change_source->Reset();
+	write_settler->Clear();
+	DEBUG_LOG("DirectoryMonitor reset. Now tracking " << change_source->GetFileCount() << " items.");
 }
 
 void DirectoryMonitor::PrintChanges(const std::vector<ChangeInfo>& changes) {
@@ -3,14 +3,33 @@
 
 #include "FileInfo.h"
 
+#include <chrono>
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace fs = std::filesystem;
 
+class WriteSettler;
+
+struct DirectoryScanOptions {
+	unsigned                  thread_count                = 0;    // Workers for full scans, 0 picks from the hardware, 1 scans on the calling thread
+	bool                      native_enumeration          = true; // Linux only: list directories with getdents64 instead of std::filesystem iterators
+	bool                      prune_unchanged_directories = true; // Skip listing directories whose mtime has not moved, for filesystems that keep directory mtimes
+	std::chrono::milliseconds write_settle_period { 250 };        // Report additions and modifications once size and mtime held still this long, 0 reports them at once
+	uintmax_t                 carry_contents_limit = 1024 * 1024; // Files up to this size reach the consumer with the bytes that were hashed, 0 never keeps them
+};
+
 class DirectoryMonitor {
 public:
+	/* A file as the backend read it to hash it, info taken before the read */
+	struct FileContents {
+		FileInfo          info;
+		std::vector<char> data;
+	};
+
 	struct ChangeInfo {
 		enum Type {
 			ADDED,
@@ -19,14 +38,51 @@ public:
 			RENAMED
 		};
 
-		Type                      type;
-		std::filesystem::path     path;
-		std::filesystem::path     old_path; // For renames
+		Type                                type;
+		std::filesystem::path               path;
+		std::filesystem::path               old_path; // For renames
+		std::shared_ptr<const FileContents> contents; // Additions and modifications only, null when the backend did not keep the bytes
+
+		[[nodiscard]] std::string           TypeToString() const;
+	};
+
+	/* What the last tick cost. Only scanning backends fill it in, an event driven one reads nothing per tick. */
+	struct ScanStatistics {
+		size_t files_scanned      = 0;
+		size_t hashes_computed    = 0;
+		size_t hashes_skipped     = 0;
+		size_t directories_listed = 0;
+		size_t directories_pruned = 0; // Unchanged since the last scan, known files stat'ed without listing
+	};
+
+	/* Produces the change stream for a directory tree. Implementations own whatever state they need to diff against. */
+	class ChangeSource {
+	public:
+		virtual ~ChangeSource()                                                          = default;
+
+		virtual std::vector<ChangeInfo>                          CollectChanges()              = 0;
+		[[nodiscard]] virtual size_t                             GetFileCount() const          = 0;
+		virtual void                                             Reset()                       = 0;
+		[[nodiscard]] virtual const char*                        GetName() const               = 0;
+		[[nodiscard]] virtual bool                               IsValid() const               = 0; // False once changes may go unseen, the monitor then falls back to polling
+		[[nodiscard]] virtual std::vector<std::filesystem::path> GetKnownFiles() const         = 0;
+		[[nodiscard]] virtual ScanStatistics                     GetLastScanStatistics() const = 0;
+	};
+
+	/* File state already known to the caller. The polling backend trusts it instead of hashing the whole tree on construction,
+	 * a file seeded without a hash is only hashed once its metadata changes. */
+	struct Seed {
+		std::unordered_map<std::filesystem::path, FileInfo> files;
+		std::chrono::time_point<std::chrono::file_clock>    hashed_since; // Every entry in files was read at or after this point
+	};
 
-		[[nodiscard]] std::string TypeToString() const;
+	enum class Backend {
+		AUTOMATIC, // Event driven where the platform supports it, polling otherwise
+		POLLING,
+		INOTIFY
 	};
 
-	explicit DirectoryMonitor(const std::filesystem::path& path, bool recurse_subdirectories = true);
+	explicit DirectoryMonitor(const std::filesystem::path& path, bool recurse_subdirectories = true, Backend backend = Backend::AUTOMATIC, DirectoryScanOptions scan_options = {}, const Seed* seed = nullptr);
 	~DirectoryMonitor();
 	DirectoryMonitor(const DirectoryMonitor& other)                  = delete;
 	DirectoryMonitor&       operator=(const DirectoryMonitor& other) = delete;
@@ -35,14 +91,20 @@ public:
 	std::vector<ChangeInfo> CheckForDirectoryChanges();
 	static void             PrintChanges(const std::vector<ChangeInfo>& changes);
 	size_t                  GetFileCount() const;
+	size_t                  GetPendingChangeCount() const; // Changes held back until their files stop being written
 	void                    ResetCache();
+	const char*             GetBackendName() const;
+	ScanStatistics          GetLastScanStatistics() const; // Of the last CheckForDirectoryChanges, same thread only
 
 private:
-	std::filesystem::path                               root_path;
-	bool                                                recurse_subdirectories;
-	std::unordered_map<std::filesystem::path, FileInfo> file_cache;
+	std::filesystem::path         root_path;
+	bool                          recurse_subdirectories;
+	DirectoryScanOptions          scan_options;
+	std::unique_ptr<ChangeSource> change_source;
+	std::unique_ptr<WriteSettler> write_settler;
 
-	std::unordered_map<std::filesystem::path, FileInfo> ScanDirectory() const;
+	std::unique_ptr<ChangeSource> CreateChangeSource(Backend backend, const Seed* seed) const;
+	void                          FallBackToPolling(std::vector<ChangeInfo>& changes);
 };
 
 #endif /*! DIRECTORYMONITOR_H_ */
@@ -1,5 +1,8 @@
 #include "FileInfo.h"
 
+#include "MappedFile.h"
+
+#define XXH_STATIC_LINKING_ONLY // XXH3_state_t definition, so the state can live in thread-local storage
 #include "xxhash.h"
 
 #include <fstream>
@@ -8,34 +11,127 @@
 #ifdef _WIN32
 #include <windows.h>
 #else
+#include <cerrno>
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/sysmacros.h>
+#endif
 #endif
 
+std::atomic<uintmax_t> FileInfo::memory_map_threshold = 4 * 1024 * 1024;
+std::atomic<uint64_t>  FileInfo::bytes_read           = 0;
+
 FileInfo::FileInfo()
     : size(0), is_directory(false) {
 }
 
-FileInfo::FileInfo(const fs::path& filepath) {
-	try {
-		if (fs::exists(filepath)) {
-			last_modified = fs::last_write_time(filepath);
-			is_directory  = fs::is_directory(filepath);
-			size          = is_directory ? 0 : fs::file_size(filepath);
-			content_hash  = is_directory ? "" : CalculateHash(filepath);
-			file_id       = is_directory ? 0 : GetFileID(filepath);
-		} else {
-			size         = 0;
-			is_directory = false;
-			content_hash = "";
-			file_id      = 0;
-		}
-	} catch (const fs::filesystem_error&) {
-		size         = 0;
-		is_directory = false;
-		content_hash = "";
-		file_id      = 0;
+FileInfo::FileInfo(const fs::path& filepath)
+    : FileInfo(ReadMetadata(filepath)) {
+	UpdateHash(filepath);
+}
+
+FileInfo FileInfo::ReadMetadata(const fs::path& filepath) {
+	std::error_code error;
+	return ReadMetadata(filepath, error);
+}
+
+FileInfo FileInfo::ReadMetadata(const fs::path& filepath, std::error_code& error) noexcept {
+	return ReadMetadata(filepath.c_str(), error);
+}
+
+FileInfo FileInfo::ReadMetadata(const fs::path::value_type* native_path, std::error_code& error) noexcept {
+	FileInfo info;
+	error.clear();
+
+#ifdef _WIN32
+	// One open plus one query yields attributes, size, write time and file index together
+	HANDLE hFile = CreateFileW(
+	    native_path,
+	    0,
+	    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+	    NULL,
+	    OPEN_EXISTING,
+	    FILE_FLAG_BACKUP_SEMANTICS, // needed for directories
+	    NULL);
+
+	if (hFile == INVALID_HANDLE_VALUE) {
+		error = std::error_code(static_cast<int>(GetLastError()), std::system_category());
+		return info;
+	}
+
+	BY_HANDLE_FILE_INFORMATION file_information;
+	const BOOL                 succeeded = GetFileInformationByHandle(hFile, &file_information);
+	CloseHandle(hFile);
+
+	if (!succeeded) {
+		error = std::error_code(static_cast<int>(GetLastError()), std::system_category());
+		return info;
+	}
+
+	// FILETIME counts 100 ns intervals since 1601-01-01
+	constexpr int64_t  FILETIME_TO_UNIX_EPOCH = 116444736000000000LL;
+	const int64_t      write_time             = (static_cast<int64_t>(file_information.ftLastWriteTime.dwHighDateTime) << 32) | file_information.ftLastWriteTime.dwLowDateTime;
+	const auto         unix_time              = std::chrono::duration<int64_t, std::ratio<1, 10000000>>(write_time - FILETIME_TO_UNIX_EPOCH);
+
+	info.is_directory                         = (file_information.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+	info.size                                 = info.is_directory ? 0 : (static_cast<uintmax_t>(file_information.nFileSizeHigh) << 32) | file_information.nFileSizeLow;
+	info.file_id                              = (static_cast<uint64_t>(file_information.nFileIndexHigh) << 32) | file_information.nFileIndexLow;
+	info.last_modified                        = std::chrono::time_point_cast<std::chrono::file_clock::duration>(std::chrono::file_clock::from_sys(std::chrono::sys_time<decltype(unix_time)>(unix_time)));
+#elif defined(__linux__)
+	return ReadMetadataAt(AT_FDCWD, native_path, error);
+#else
+	struct stat stat_buf;
+	if (stat(native_path, &stat_buf) != 0) {
+		error = std::error_code(errno, std::generic_category());
+		return info;
 	}
+
+	const bool     is_directory = S_ISDIR(stat_buf.st_mode);
+	const uint64_t device       = stat_buf.st_dev;
+	const uint64_t inode        = stat_buf.st_ino;
+	const auto     unix_time    = std::chrono::seconds(stat_buf.st_mtim.tv_sec) + std::chrono::nanoseconds(stat_buf.st_mtim.tv_nsec);
+
+	info.is_directory           = is_directory;
+	info.size                   = is_directory ? 0 : static_cast<uintmax_t>(stat_buf.st_size);
+	info.file_id                = (device << 32) | inode;
+	info.last_modified          = std::chrono::time_point_cast<std::chrono::file_clock::duration>(std::chrono::file_clock::from_sys(std::chrono::sys_time<std::chrono::nanoseconds>(unix_time)));
+#endif
+
+	return info;
+}
+
+#ifdef __linux__
+FileInfo FileInfo::ReadMetadataAt(int directory_fd, const char* name, std::error_code& error) noexcept {
+	FileInfo info;
+	error.clear();
+
+	struct statx stat_buf;
+	if (statx(directory_fd, name, AT_STATX_SYNC_AS_STAT, STATX_TYPE | STATX_SIZE | STATX_MTIME | STATX_INO, &stat_buf) != 0) {
+		error = std::error_code(errno, std::generic_category());
+		return info;
+	}
+
+	const bool     is_directory = S_ISDIR(stat_buf.stx_mode);
+	const uint64_t device       = makedev(stat_buf.stx_dev_major, stat_buf.stx_dev_minor);
+	const auto     unix_time    = std::chrono::seconds(stat_buf.stx_mtime.tv_sec) + std::chrono::nanoseconds(stat_buf.stx_mtime.tv_nsec);
+
+	info.is_directory           = is_directory;
+	info.size                   = is_directory ? 0 : static_cast<uintmax_t>(stat_buf.stx_size);
+	info.file_id                = (device << 32) | stat_buf.stx_ino;
+	info.last_modified          = std::chrono::time_point_cast<std::chrono::file_clock::duration>(std::chrono::file_clock::from_sys(std::chrono::sys_time<std::chrono::nanoseconds>(unix_time)));
+	return info;
+}
+#endif
+
+void FileInfo::UpdateHash(const fs::path& filepath) {
+	content_hash = is_directory ? 0 : CalculateHash(filepath, size);
+}
+
+void FileInfo::UpdateHash(const fs::path& filepath, std::vector<char>& contents) {
+	contents.clear();
+	content_hash = is_directory ? 0 : ReadAndHash(filepath, size, contents);
 }
 
 bool FileInfo::operator!=(const FileInfo& other) const {
@@ -46,23 +142,103 @@ bool FileInfo::operator!=(const FileInfo& other) const {
 }
 
 bool FileInfo::HasSameContent(const FileInfo& other) const {
-	return !content_hash.empty() &&
+	return content_hash != 0 &&
 	       content_hash == other.content_hash &&
 	       size == other.size &&
 	       is_directory == other.is_directory;
 }
 
-std::string FileInfo::CalculateHash(const fs::path& filepath) {
+bool FileInfo::HasSameMetadata(const FileInfo& other) const {
+	return file_id != 0 &&
+	       file_id == other.file_id &&
+	       size == other.size &&
+	       last_modified == other.last_modified &&
+	       is_directory == other.is_directory;
+}
+
+void FileInfo::SetMemoryMapThreshold(uintmax_t bytes) {
+	memory_map_threshold.store(bytes);
+}
+
+uint64_t FileInfo::GetBytesRead() {
+	return bytes_read.load(std::memory_order_relaxed);
+}
+
+uint64_t FileInfo::CalculateHash(const fs::path& filepath, uintmax_t size) {
+	const uintmax_t threshold = memory_map_threshold.load(std::memory_order_relaxed);
+	if (threshold != 0 && size >= threshold) {
+		if (const uint64_t hash = CalculateHashMapped(filepath); hash != 0) {
+			return hash;
+		}
+	}
+
+	return CalculateHashStreaming(filepath);
+}
+
+uint64_t FileInfo::CalculateHashStreaming(const fs::path& filepath) {
+	// One buffer and one hash state per thread, reused for every file that thread hashes
+	struct alignas(64) HashBuffer {
+		char data[64 * 1024];
+	};
+	thread_local HashBuffer   buffer;
+	thread_local XXH3_state_t state;
+
 	try {
-		std::ifstream file(filepath, std::ios::binary);
+		std::ifstream file;
+		file.rdbuf()->pubsetbuf(nullptr, 0); // Unbuffered, reads go straight into our buffer
+		file.open(filepath, std::ios::binary);
 		if (!file.is_open())
-			return "";
+			return 0;
 
-		std::vector<char> buffer((std::istreambuf_iterator<char>(file)), {});
-		uint64_t          hash = XXH3_64bits(buffer.data(), buffer.size());
-		return std::to_string(hash);
+		if (XXH3_64bits_reset(&state) == XXH_ERROR)
+			return 0;
+
+		while (file.read(buffer.data, sizeof(buffer.data)) || file.gcount() > 0) {
+			XXH3_64bits_update(&state, buffer.data, static_cast<size_t>(file.gcount()));
+			bytes_read.fetch_add(static_cast<uint64_t>(file.gcount()), std::memory_order_relaxed);
+		}
+
+		return XXH3_64bits_digest(&state);
 	} catch (...) {
-		return "";
+		return 0;
+	}
+}
+
+uint64_t FileInfo::CalculateHashMapped(const fs::path& filepath) {
+	const MappedFile mapping(filepath);
+	if (!mapping.IsValid()) {
+		return 0;
+	}
+
+	bytes_read.fetch_add(mapping.size(), std::memory_order_relaxed);
+	return XXH3_64bits(mapping.data(), mapping.size());
+}
+
+uint64_t FileInfo::ReadAndHash(const fs::path& filepath, uintmax_t size, std::vector<char>& contents) {
+	try {
+		std::ifstream file;
+		file.rdbuf()->pubsetbuf(nullptr, 0);
+		file.open(filepath, std::ios::binary);
+		if (!file.is_open())
+			return 0;
+
+		// Sized from the stat, then grown in case the file was appended to since
+		constexpr size_t GROWTH = 64 * 1024;
+		size_t           filled = 0;
+		contents.resize(static_cast<size_t>(size) + 1);
+		while (file.read(contents.data() + filled, static_cast<std::streamsize>(contents.size() - filled)) || file.gcount() > 0) {
+			filled += static_cast<size_t>(file.gcount());
+			if (filled == contents.size()) {
+				contents.resize(filled + GROWTH);
+			}
+		}
+
+		contents.resize(filled);
+		bytes_read.fetch_add(filled, std::memory_order_relaxed);
+		return XXH3_64bits(contents.data(), contents.size());
+	} catch (...) {
+		contents.clear();
+		return 0;
 	}
 }
 
@@ -1,26 +1,59 @@
 #ifndef FILEINFO_H_
 #define FILEINFO_H_
 
+#include <atomic>
+#include <cstdint>
 #include <filesystem>
+#include <system_error>
+#include <vector>
 
 namespace fs = std::filesystem;
 
+/* Packed into 32 bytes, the polling backend keeps one per tracked file. */
 struct FileInfo {
 	std::chrono::time_point<std::chrono::file_clock> last_modified;
-	uintmax_t                                        size;
-	bool                                             is_directory;
-	std::string                                      content_hash;
-	uint64_t                                         file_id = 0;
+	uint64_t                                         size         : 63;
+	uint64_t                                         is_directory : 1;
+	uint64_t                                         content_hash = 0; // XXH3-64 of the contents, 0 when unknown
+	uint64_t                                         file_id      = 0;
 
 	FileInfo();
 	explicit FileInfo(const fs::path& filepath);
 	bool               operator!=(const FileInfo& other) const;
 
+	// Fills everything but the hash from a single platform call (statx, stat or GetFileInformationByHandle). Never throws.
+	static FileInfo    ReadMetadata(const fs::path& filepath);
+	static FileInfo    ReadMetadata(const fs::path& filepath, std::error_code& error) noexcept;
+	static FileInfo    ReadMetadata(const fs::path::value_type* native_path, std::error_code& error) noexcept; // Without building a path
+#ifdef __linux__
+	// statx relative to an open directory descriptor, for walkers that never build the full path of files they skip
+	static FileInfo    ReadMetadataAt(int directory_fd, const char* name, std::error_code& error) noexcept;
+#endif
+	void               UpdateHash(const fs::path& filepath);
+	void               UpdateHash(const fs::path& filepath, std::vector<char>& contents); // Keeps the bytes it hashed
+
 	uint64_t           GetFileID(const fs::path& filepath);
 	[[nodiscard]] bool HasSameContent(const FileInfo& other) const;
+	[[nodiscard]] bool HasSameMetadata(const FileInfo& other) const;
+
+	// Files at least this large are hashed through a read-only mapping instead of buffered reads. 0 disables mapping.
+	static void                           SetMemoryMapThreshold(uintmax_t bytes);
+	// Bytes read from disk for hashing since startup, across all threads
+	static uint64_t                       GetBytesRead();
+
+	// Coarsest mtime resolution we expect to meet (FAT). A file written this close to a hash may change again without its mtime moving.
+	static constexpr std::chrono::seconds TIMESTAMP_GRANULARITY { 2 };
 
 private:
-	static std::string CalculateHash(const fs::path& filepath);
+	static std::atomic<uintmax_t> memory_map_threshold;
+	static std::atomic<uint64_t>  bytes_read;
+
+	static uint64_t               CalculateHash(const fs::path& filepath, uintmax_t size);
+	static uint64_t               CalculateHashStreaming(const fs::path& filepath);
+	static uint64_t               CalculateHashMapped(const fs::path& filepath);
+	static uint64_t               ReadAndHash(const fs::path& filepath, uintmax_t size, std::vector<char>& contents);
 };
 
+static_assert(sizeof(FileInfo) == 32, "FileInfo is meant to stay packed");
+
 #endif /*! FILEINFO_H_ */
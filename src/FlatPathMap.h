@@ -0,0 +1,248 @@
+#ifndef FLATPATHMAP_H_
+#define FLATPATHMAP_H_
+
+#include "PathArena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/* Key part of a FlatPathMap record. The path is NUL-terminated, so it can go straight to the platform's file calls. */
+struct FlatPathMapNode {
+	PathArena::PathView path;
+	uint64_t            path_hash  = 0;
+	uint32_t            node_index = 0;
+
+	[[nodiscard]] const PathArena::PathChar* c_str() const {
+		return path.data();
+	}
+};
+
+/* Open-addressing (linear probing) map from a path to a record that carries its own key. T derives from FlatPathMapNode.
+ * Records live in fixed-size chunks and never move, so pointers to them stay valid until they are erased. Keys are stored
+ * once in a PathArena and looked up by view, so probing never builds a std::filesystem::path. */
+template <typename T>
+class FlatPathMap {
+public:
+	using PathView = PathArena::PathView;
+
+	// Inserts a default record for the path unless one exists. Returns the record and whether it was inserted.
+	std::pair<T*, bool> TryEmplace(PathView path) {
+		if ((used_slots + 1) * 4 > slots.size() * 3) {
+			Rehash();
+		}
+
+		const uint64_t hash     = std::hash<PathView> {}(path);
+		const size_t   mask     = slots.size() - 1;
+		size_t         reusable = slots.size();
+		size_t         slot     = hash & mask;
+		for (;; slot = (slot + 1) & mask) {
+			const uint32_t value = slots[slot];
+			if (value == EMPTY_SLOT)
+				break;
+			if (value == ERASED_SLOT) {
+				if (reusable == slots.size()) {
+					reusable = slot;
+				}
+				continue;
+			}
+
+			T& node = NodeAt(value - 1);
+			if (node.path_hash == hash && node.path == path)
+				return { &node, false };
+		}
+
+		if (reusable != slots.size()) {
+			slot = reusable; // Tombstone reuse keeps used_slots unchanged
+		} else {
+			used_slots++;
+		}
+
+		uint32_t index;
+		if (!free_nodes.empty()) {
+			index = free_nodes.back();
+			free_nodes.pop_back();
+		} else {
+			index = allocated_nodes++;
+			if ((index >> CHUNK_SHIFT) == chunks.size()) {
+				chunks.push_back(std::make_unique<T[]>(CHUNK_SIZE));
+			}
+		}
+
+		T& node          = NodeAt(index);
+		node.path        = arena.Store(path);
+		node.path_hash   = hash;
+		node.node_index  = index;
+		slots[slot]      = index + 1;
+		live_nodes++;
+		return { &node, true };
+	}
+
+	[[nodiscard]] T* Find(PathView path) const {
+		if (slots.empty())
+			return nullptr;
+
+		const uint64_t hash = std::hash<PathView> {}(path);
+		const size_t   mask = slots.size() - 1;
+		for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+			const uint32_t value = slots[slot];
+			if (value == EMPTY_SLOT)
+				return nullptr;
+			if (value == ERASED_SLOT)
+				continue;
+
+			T& node = NodeAt(value - 1);
+			if (node.path_hash == hash && node.path == path)
+				return &node;
+		}
+	}
+
+	void Erase(T* node) {
+		const size_t mask = slots.size() - 1;
+		for (size_t slot = node->path_hash & mask;; slot = (slot + 1) & mask) {
+			if (slots[slot] == node->node_index + 1) {
+				slots[slot] = ERASED_SLOT;
+				break;
+			}
+		}
+
+		arena.Release(node->path);
+		free_nodes.push_back(node->node_index);
+		*node = T {};
+		live_nodes--;
+	}
+
+	// Moves a record to another key in place, so its address and node_index survive. The new key must not be present.
+	void Rekey(T* node, PathView path) {
+		const size_t mask = slots.size() - 1;
+		for (size_t slot = node->path_hash & mask;; slot = (slot + 1) & mask) {
+			if (slots[slot] == node->node_index + 1) {
+				slots[slot] = ERASED_SLOT;
+				break;
+			}
+		}
+
+		arena.Release(node->path);
+		node->path      = arena.Store(path);
+		node->path_hash = std::hash<PathView> {}(path);
+
+		if ((used_slots + 1) * 4 > slots.size() * 3) {
+			Rehash(); // Places every live record, this one included
+			return;
+		}
+
+		size_t slot = node->path_hash & mask;
+		while (slots[slot] != EMPTY_SLOT && slots[slot] != ERASED_SLOT) {
+			slot = (slot + 1) & mask;
+		}
+		if (slots[slot] == EMPTY_SLOT) {
+			used_slots++;
+		}
+		slots[slot] = node->node_index + 1;
+	}
+
+	template <typename Function>
+	void ForEach(Function&& function) {
+		for (uint32_t index = 0; index < allocated_nodes; ++index) {
+			T& node = NodeAt(index);
+			if (node.path.data()) {
+				function(node);
+			}
+		}
+	}
+
+	template <typename Function>
+	void ForEach(Function&& function) const {
+		for (uint32_t index = 0; index < allocated_nodes; ++index) {
+			const T& node = NodeAt(index);
+			if (node.path.data()) {
+				function(node);
+			}
+		}
+	}
+
+	template <typename Predicate>
+	void EraseIf(Predicate&& predicate) {
+		for (uint32_t index = 0; index < allocated_nodes; ++index) {
+			T& node = NodeAt(index);
+			if (node.path.data() && predicate(node)) {
+				Erase(&node);
+			}
+		}
+	}
+
+	// Copies the live keys into a fresh arena once more than half of it is dead. Not safe while records are in use elsewhere.
+	void CompactPaths() {
+		if (arena.GetDeadCharacters() < COMPACT_MINIMUM || arena.GetDeadCharacters() < arena.GetLiveCharacters())
+			return;
+
+		PathArena compacted;
+		ForEach([&compacted](T& node) {
+			node.path = compacted.Store(node.path);
+		});
+		arena = std::move(compacted);
+	}
+
+	void Clear() {
+		chunks.clear();
+		free_nodes.clear();
+		slots.clear();
+		arena.Clear();
+		allocated_nodes = 0;
+		live_nodes      = 0;
+		used_slots      = 0;
+	}
+
+	[[nodiscard]] size_t Size() const {
+		return live_nodes;
+	}
+
+private:
+	static constexpr uint32_t             EMPTY_SLOT      = 0; // Slots hold node index + 1
+	static constexpr uint32_t             ERASED_SLOT     = UINT32_MAX;
+	static constexpr uint32_t             CHUNK_SHIFT     = 10;
+	static constexpr uint32_t             CHUNK_SIZE      = 1u << CHUNK_SHIFT;
+	static constexpr size_t               MINIMUM_SLOTS   = 64;
+	static constexpr size_t               COMPACT_MINIMUM = 64 * 1024;
+
+	std::vector<std::unique_ptr<T[]>>     chunks;
+	std::vector<uint32_t>                 free_nodes;
+	std::vector<uint32_t>                 slots;
+	PathArena                             arena;
+	uint32_t                              allocated_nodes = 0;
+	size_t                                live_nodes      = 0;
+	size_t                                used_slots      = 0; // Live plus erased, what probing has to step over
+
+	[[nodiscard]] T& NodeAt(uint32_t index) const {
+		return chunks[index >> CHUNK_SHIFT][index & (CHUNK_SIZE - 1)];
+	}
+
+	// Grows when live records fill the table, otherwise rebuilds at the same size to drop tombstones
+	void Rehash() {
+		size_t capacity = std::max(MINIMUM_SLOTS, slots.size());
+		while ((live_nodes + 1) * 2 > capacity) {
+			capacity *= 2;
+		}
+
+		slots.assign(capacity, EMPTY_SLOT);
+		used_slots = live_nodes;
+
+		const size_t mask = capacity - 1;
+		for (uint32_t index = 0; index < allocated_nodes; ++index) {
+			const T& node = NodeAt(index);
+			if (!node.path.data())
+				continue;
+
+			size_t slot = node.path_hash & mask;
+			while (slots[slot] != EMPTY_SLOT) {
+				slot = (slot + 1) & mask;
+			}
+			slots[slot] = index + 1;
+		}
+	}
+};
+
+#endif /*! FLATPATHMAP_H_ */
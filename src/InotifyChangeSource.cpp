@@ -0,0 +1,383 @@
+#include "InotifyChangeSource.h"
+
+#ifdef __linux__
+
+#include "Debug.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace {
+	// IN_MODIFY is left out on purpose, a preset is only worth reloading once its writer has closed it.
+	constexpr uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK;
+
+	bool IsCusFile(const fs::path& path) {
+		return path.extension() == ".cus";
+	}
+
+	bool IsSameOrUnder(const fs::path& path, const fs::path& directory) {
+		const auto& path_string      = path.native();
+		const auto& directory_string = directory.native();
+
+		if (path_string.size() < directory_string.size() || path_string.compare(0, directory_string.size(), directory_string) != 0)
+			return false;
+
+		return path_string.size() == directory_string.size() || path_string[directory_string.size()] == fs::path::preferred_separator;
+	}
+
+	fs::path Rebase(const fs::path& path, const fs::path& old_directory, const fs::path& new_directory) {
+		if (path.native().size() == old_directory.native().size())
+			return new_directory;
+
+		return new_directory / path.native().substr(old_directory.native().size() + 1);
+	}
+} // namespace
+
+InotifyChangeSource::InotifyChangeSource(const std::filesystem::path& root_path, bool recurse_subdirectories)
+    : root_path(root_path), recurse_subdirectories(recurse_subdirectories), inotify_fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {
+	if (inotify_fd < 0) {
+		DEBUG_LOG("inotify_init1 failed: " << std::strerror(errno));
+		return;
+	}
+
+	AddWatchRecursive(root_path, nullptr);
+	DEBUG_LOG("inotify watching " << watch_paths.size() << " directories, " << known_files.size() << " files.");
+}
+
+InotifyChangeSource::~InotifyChangeSource() {
+	if (inotify_fd >= 0) {
+		close(inotify_fd); // Closing the descriptor drops every watch with it
+	}
+}
+
+bool InotifyChangeSource::IsValid() const {
+	return inotify_fd >= 0 && !watch_failed && watch_descriptors.contains(root_path);
+}
+
+std::vector<std::filesystem::path> InotifyChangeSource::GetKnownFiles() const {
+	return { known_files.begin(), known_files.end() };
+}
+
+DirectoryMonitor::ScanStatistics InotifyChangeSource::GetLastScanStatistics() const {
+	return {};
+}
+
+size_t InotifyChangeSource::GetFileCount() const {
+	return known_files.size();
+}
+
+const char* InotifyChangeSource::GetName() const {
+	return "inotify";
+}
+
+std::vector<DirectoryMonitor::ChangeInfo> InotifyChangeSource::CollectChanges() {
+	using ChangeInfo = DirectoryMonitor::ChangeInfo;
+
+	std::vector<ChangeInfo> changes;
+	if (inotify_fd < 0)
+		return changes;
+
+	alignas(inotify_event) char buffer[16 * 1024];
+	while (true) {
+		const ssize_t length = read(inotify_fd, buffer, sizeof(buffer));
+		if (length < 0 && errno == EINTR)
+			continue;
+		if (length <= 0)
+			break; // EAGAIN, queue drained
+
+		for (ssize_t offset = 0; offset < length;) {
+			const auto* event  = reinterpret_cast<const inotify_event*>(buffer + offset);
+			HandleEvent(*event, changes);
+			offset            += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+		}
+	}
+
+	// The kernel queues both halves of a rename together, so a move still unpaired after draining left the tree
+	for (const auto& [cookie, move] : pending_moves) {
+		if (move.is_directory) {
+			for (const auto& file : KnownFilesUnder(move.path)) {
+				Forget(changes, file);
+			}
+			RemoveWatchesUnder(move.path);
+		} else if (known_files.contains(move.path)) {
+			Forget(changes, move.path);
+		}
+	}
+	pending_moves.clear();
+
+	if (overflowed) {
+		overflowed = false;
+		Resynchronize(changes);
+	}
+
+	loaded_this_batch.clear();
+	return changes;
+}
+
+void InotifyChangeSource::Reset() {
+	RemoveAllWatches();
+	watch_failed = false;
+	known_files.clear();
+	created_files.clear();
+	pending_moves.clear();
+	AddWatchRecursive(root_path, nullptr);
+}
+
+void InotifyChangeSource::Emit(std::vector<DirectoryMonitor::ChangeInfo>& changes, DirectoryMonitor::ChangeInfo::Type type, const std::filesystem::path& path, const std::filesystem::path& old_path) {
+	using ChangeInfo = DirectoryMonitor::ChangeInfo;
+
+	switch (type) {
+		case ChangeInfo::MODIFIED:
+			// Create followed by close-write in the same batch only needs one load
+			if (!loaded_this_batch.insert(path).second)
+				return;
+			break;
+		case ChangeInfo::ADDED:
+			loaded_this_batch.insert(path);
+			break;
+		case ChangeInfo::RENAMED:
+			loaded_this_batch.erase(old_path);
+			loaded_this_batch.insert(path);
+			break;
+		case ChangeInfo::DELETED:
+			loaded_this_batch.erase(path);
+			break;
+	}
+
+	changes.push_back({ type, path, old_path, nullptr });
+}
+
+void InotifyChangeSource::HandleEvent(const inotify_event& event, std::vector<DirectoryMonitor::ChangeInfo>& changes) {
+	using ChangeInfo = DirectoryMonitor::ChangeInfo;
+
+	if (event.mask & IN_Q_OVERFLOW) {
+		overflowed = true;
+		return;
+	}
+
+	const auto watch_iterator = watch_paths.find(event.wd);
+	if (watch_iterator == watch_paths.end())
+		return;
+
+	if (event.mask & IN_IGNORED) {
+		auto descriptor_iterator = watch_descriptors.find(watch_iterator->second);
+		if (descriptor_iterator != watch_descriptors.end() && descriptor_iterator->second == event.wd) {
+			watch_descriptors.erase(descriptor_iterator);
+		}
+		watch_paths.erase(watch_iterator);
+		return;
+	}
+
+	if (event.mask & IN_DELETE_SELF) {
+		if (watch_iterator->second == root_path) {
+			DEBUG_LOG("Monitored directory was removed: " << root_path);
+		}
+		return;
+	}
+
+	const fs::path directory    = watch_iterator->second;
+	const fs::path path         = event.len > 0 ? directory / event.name : directory;
+	const bool     is_directory = (event.mask & IN_ISDIR) != 0;
+
+	if (event.mask & IN_MOVED_FROM) {
+		pending_moves[event.cookie] = PendingMove { path, is_directory };
+		return;
+	}
+
+	if (event.mask & IN_MOVED_TO) {
+		auto move_iterator = pending_moves.find(event.cookie);
+		if (move_iterator != pending_moves.end()) {
+			const PendingMove move = std::move(move_iterator->second);
+			pending_moves.erase(move_iterator);
+
+			if (is_directory) {
+				RenameWatchesUnder(move.path, path);
+				for (const auto& old_file : KnownFilesUnder(move.path)) {
+					fs::path new_file = Rebase(old_file, move.path, path);
+					known_files.erase(old_file);
+					known_files.insert(new_file);
+					if (created_files.erase(old_file) > 0) {
+						created_files.insert(new_file); // Still being written, reported once closed under its new name
+					} else {
+						Emit(changes, ChangeInfo::RENAMED, new_file, old_file);
+					}
+				}
+				return;
+			}
+
+			const bool was_known = known_files.contains(move.path);
+			if (was_known && IsCusFile(path)) {
+				known_files.erase(move.path);
+				known_files.insert(path);
+				if (created_files.erase(move.path) > 0) {
+					created_files.insert(path);
+				} else {
+					Emit(changes, ChangeInfo::RENAMED, path, move.path);
+				}
+			} else if (was_known) {
+				Forget(changes, move.path);
+			} else if (IsCusFile(path)) {
+				// Renamed over an existing preset (temp file then rename) replaces its content
+				created_files.erase(path);
+				Emit(changes, known_files.insert(path).second ? ChangeInfo::ADDED : ChangeInfo::MODIFIED, path);
+			}
+			return;
+		}
+		// No matching half, moved in from outside the tree. Handle like a creation.
+	}
+
+	if (event.mask & (IN_CREATE | IN_MOVED_TO)) {
+		if (is_directory) {
+			if (!recurse_subdirectories)
+				return;
+
+			// Files can land in a new directory before its watch exists, so enumerate it once
+			std::vector<fs::path> discovered_files;
+			AddWatchRecursive(path, &discovered_files);
+			for (const auto& file : discovered_files) {
+				Emit(changes, ChangeInfo::ADDED, file);
+			}
+		} else if (IsCusFile(path) && (event.mask & IN_MOVED_TO)) {
+			// Moved in whole, there is no writer to wait for
+			created_files.erase(path);
+			Emit(changes, known_files.insert(path).second ? ChangeInfo::ADDED : ChangeInfo::MODIFIED, path);
+		} else if (IsCusFile(path) && known_files.insert(path).second) {
+			created_files.insert(path); // Empty or half written until its writer closes it
+		}
+		return;
+	}
+
+	if (event.mask & IN_CLOSE_WRITE) {
+		if (!IsCusFile(path))
+			return;
+
+		const bool created = created_files.erase(path) > 0;
+		if (known_files.insert(path).second || created) {
+			Emit(changes, ChangeInfo::ADDED, path);
+		} else {
+			Emit(changes, ChangeInfo::MODIFIED, path);
+		}
+		return;
+	}
+
+	if (event.mask & IN_DELETE) {
+		if (is_directory) {
+			for (const auto& file : KnownFilesUnder(path)) {
+				Forget(changes, file);
+			}
+			RemoveWatchesUnder(path);
+		} else if (known_files.contains(path)) {
+			Forget(changes, path);
+		}
+	}
+}
+
+void InotifyChangeSource::Forget(std::vector<DirectoryMonitor::ChangeInfo>& changes, const std::filesystem::path& path) {
+	known_files.erase(path);
+	if (created_files.erase(path) == 0) {
+		Emit(changes, DirectoryMonitor::ChangeInfo::DELETED, path);
+	}
+}
+
+void InotifyChangeSource::AddWatchRecursive(const std::filesystem::path& directory, std::vector<std::filesystem::path>* discovered_files) {
+	const int watch_descriptor = inotify_add_watch(inotify_fd, directory.c_str(), WATCH_MASK);
+	if (watch_descriptor < 0) {
+		// ENOSPC at max_user_watches or EACCES, either way nothing below is seen again. The monitor moves to polling.
+		DEBUG_LOG("inotify_add_watch failed for " << directory << ": " << std::strerror(errno));
+		watch_failed = true;
+		return;
+	}
+
+	watch_paths[watch_descriptor] = directory;
+	watch_descriptors[directory]  = watch_descriptor;
+
+	std::error_code error;
+	for (fs::directory_iterator iterator(directory, fs::directory_options::skip_permission_denied, error), end; !error && iterator != end; iterator.increment(error)) {
+		const fs::directory_entry& entry = *iterator;
+		std::error_code            status_error;
+
+		if (entry.is_directory(status_error) && !entry.is_symlink(status_error)) {
+			if (recurse_subdirectories) {
+				AddWatchRecursive(entry.path(), discovered_files);
+			}
+		} else if (entry.is_regular_file(status_error) && IsCusFile(entry.path())) {
+			if (known_files.insert(entry.path()).second && discovered_files) {
+				discovered_files->push_back(entry.path());
+			}
+		}
+	}
+}
+
+void InotifyChangeSource::RemoveWatchesUnder(const std::filesystem::path& directory) {
+	for (auto iterator = watch_descriptors.begin(); iterator != watch_descriptors.end();) {
+		if (IsSameOrUnder(iterator->first, directory)) {
+			inotify_rm_watch(inotify_fd, iterator->second); // Fails harmlessly if the kernel already dropped it
+			watch_paths.erase(iterator->second);
+			iterator = watch_descriptors.erase(iterator);
+		} else {
+			++iterator;
+		}
+	}
+}
+
+void InotifyChangeSource::RenameWatchesUnder(const std::filesystem::path& old_directory, const std::filesystem::path& new_directory) {
+	std::vector<std::pair<fs::path, int>> moved_watches;
+	for (const auto& [path, watch_descriptor] : watch_descriptors) {
+		if (IsSameOrUnder(path, old_directory)) {
+			moved_watches.emplace_back(path, watch_descriptor);
+		}
+	}
+
+	for (const auto& [old_path, watch_descriptor] : moved_watches) {
+		fs::path new_path = Rebase(old_path, old_directory, new_directory);
+		watch_descriptors.erase(old_path);
+		watch_descriptors[new_path]   = watch_descriptor;
+		watch_paths[watch_descriptor] = std::move(new_path);
+	}
+}
+
+void InotifyChangeSource::RemoveAllWatches() {
+	for (const auto& [watch_descriptor, path] : watch_paths) {
+		inotify_rm_watch(inotify_fd, watch_descriptor);
+	}
+	watch_paths.clear();
+	watch_descriptors.clear();
+}
+
+void InotifyChangeSource::Resynchronize(std::vector<DirectoryMonitor::ChangeInfo>& changes) {
+	using ChangeInfo = DirectoryMonitor::ChangeInfo;
+
+	DEBUG_LOG("inotify queue overflowed, rescanning " << root_path);
+
+	const auto previous_files = std::move(known_files);
+	known_files.clear();
+	created_files.clear();
+	RemoveAllWatches();
+	watch_failed = false;
+	AddWatchRecursive(root_path, nullptr);
+
+	for (const auto& file : previous_files) {
+		if (!known_files.contains(file)) {
+			Emit(changes, ChangeInfo::DELETED, file);
+		}
+	}
+
+	// Events were lost, so any surviving file may have been rewritten
+	for (const auto& file : known_files) {
+		Emit(changes, previous_files.contains(file) ? ChangeInfo::MODIFIED : ChangeInfo::ADDED, file);
+	}
+}
+
+std::vector<std::filesystem::path> InotifyChangeSource::KnownFilesUnder(const std::filesystem::path& directory) const {
+	std::vector<fs::path> files;
+	for (const auto& file : known_files) {
+		if (file != directory && IsSameOrUnder(file, directory)) {
+			files.push_back(file);
+		}
+	}
+	return files;
+}
+
+#endif // __linux__
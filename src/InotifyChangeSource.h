@@ -0,0 +1,64 @@
+#ifndef INOTIFYCHANGESOURCE_H_
+#define INOTIFYCHANGESOURCE_H_
+
+#ifdef __linux__
+
+#include "DirectoryMonitor.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+
+struct inotify_event;
+
+/* Linux backend: one inotify watch per directory, new subdirectories are watched as they appear.
+ * A tick drains the non-blocking descriptor, so an idle tree costs a single read() per call. */
+class InotifyChangeSource final : public DirectoryMonitor::ChangeSource {
+public:
+	InotifyChangeSource(const std::filesystem::path& root_path, bool recurse_subdirectories);
+	~InotifyChangeSource() override;
+	InotifyChangeSource(const InotifyChangeSource& other)                                               = delete;
+	InotifyChangeSource&                                    operator=(const InotifyChangeSource& other) = delete;
+
+	std::vector<DirectoryMonitor::ChangeInfo>               CollectChanges() override;
+	[[nodiscard]] size_t                                    GetFileCount() const override;
+	void                                                    Reset() override;
+	[[nodiscard]] const char*                               GetName() const override;
+	[[nodiscard]] bool                                      IsValid() const override; // False once a directory could not be watched
+	[[nodiscard]] std::vector<std::filesystem::path>        GetKnownFiles() const override;
+	[[nodiscard]] DirectoryMonitor::ScanStatistics          GetLastScanStatistics() const override; // Always empty, nothing is scanned
+
+private:
+	struct PendingMove {
+		std::filesystem::path path;
+		bool                  is_directory;
+	};
+
+	std::filesystem::path                                   root_path;
+	bool                                                    recurse_subdirectories;
+	int                                                     inotify_fd   = -1;
+	bool                                                    overflowed   = false;
+	bool                                                    watch_failed = false; // A subtree is unwatched, its changes would be missed
+
+	std::unordered_map<int, std::filesystem::path>          watch_paths;
+	std::unordered_map<std::filesystem::path, int>          watch_descriptors;
+	std::unordered_set<std::filesystem::path>               known_files;
+	std::unordered_set<std::filesystem::path>               created_files; // Known but not reported yet, their writer has not closed them
+	std::unordered_map<uint32_t, PendingMove>               pending_moves;
+	std::unordered_set<std::filesystem::path>               loaded_this_batch;
+
+	void                                                    Emit(std::vector<DirectoryMonitor::ChangeInfo>& changes, DirectoryMonitor::ChangeInfo::Type type, const std::filesystem::path& path, const std::filesystem::path& old_path = {});
+	void                                                    Forget(std::vector<DirectoryMonitor::ChangeInfo>& changes, const std::filesystem::path& path); // Reported deleted if it was ever reported
+	void                                                    HandleEvent(const inotify_event& event, std::vector<DirectoryMonitor::ChangeInfo>& changes);
+	void                                                    AddWatchRecursive(const std::filesystem::path& directory, std::vector<std::filesystem::path>* discovered_files);
+	void                                                    RemoveWatchesUnder(const std::filesystem::path& directory);
+	void                                                    RenameWatchesUnder(const std::filesystem::path& old_directory, const std::filesystem::path& new_directory);
+	void                                                    RemoveAllWatches();
+	void                                                    Resynchronize(std::vector<DirectoryMonitor::ChangeInfo>& changes);
+	[[nodiscard]] std::vector<std::filesystem::path>        KnownFilesUnder(const std::filesystem::path& directory) const;
+};
+
+#endif // __linux__
+
+#endif /*! INOTIFYCHANGESOURCE_H_ */
@@ -0,0 +1,106 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::filesystem::path& filepath) {
+#ifdef _WIN32
+	HANDLE hFile = CreateFileW(filepath.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return;
+	}
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(hFile, &file_size) || file_size.QuadPart == 0) {
+		CloseHandle(hFile);
+		return;
+	}
+
+	HANDLE hMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(hFile);
+	if (hMapping == NULL) {
+		return;
+	}
+
+	const void* mapped = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(hMapping); // The view keeps the mapping alive
+	if (mapped == NULL) {
+		return;
+	}
+
+	view      = static_cast<const char*>(mapped);
+	view_size = static_cast<size_t>(file_size.QuadPart);
+#else
+	const int fd = open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return;
+	}
+
+	struct stat stat_buf;
+	if (fstat(fd, &stat_buf) != 0 || stat_buf.st_size == 0) {
+		close(fd);
+		return;
+	}
+
+	void* mapped = mmap(nullptr, static_cast<size_t>(stat_buf.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED) {
+		return;
+	}
+
+	madvise(mapped, static_cast<size_t>(stat_buf.st_size), MADV_SEQUENTIAL);
+	view      = static_cast<const char*>(mapped);
+	view_size = static_cast<size_t>(stat_buf.st_size);
+#endif
+}
+
+MappedFile::~MappedFile() {
+	Unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : view(std::exchange(other.view, nullptr)), view_size(std::exchange(other.view_size, 0)) {
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if (this != &other) {
+		Unmap();
+		view      = std::exchange(other.view, nullptr);
+		view_size = std::exchange(other.view_size, 0);
+	}
+	return *this;
+}
+
+const char* MappedFile::data() const {
+	return view;
+}
+
+size_t MappedFile::size() const {
+	return view_size;
+}
+
+bool MappedFile::IsValid() const {
+	return view != nullptr;
+}
+
+void MappedFile::Unmap() {
+	if (view == nullptr) {
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(view);
+#else
+	munmap(const_cast<char*>(view), view_size);
+#endif
+	view      = nullptr;
+	view_size = 0;
+}
@@ -0,0 +1,29 @@
+#ifndef MAPPEDFILE_H_
+#define MAPPEDFILE_H_
+
+#include <cstddef>
+#include <filesystem>
+
+/* Read-only view of a whole file. An empty or unreadable file yields an invalid mapping. */
+class MappedFile {
+public:
+	MappedFile() = default;
+	explicit MappedFile(const std::filesystem::path& filepath);
+	~MappedFile();
+	MappedFile(const MappedFile& other)                      = delete;
+	MappedFile&               operator=(const MappedFile& other) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile&               operator=(MappedFile&& other) noexcept;
+
+	[[nodiscard]] const char* data() const;
+	[[nodiscard]] size_t      size() const;
+	[[nodiscard]] bool        IsValid() const;
+
+private:
+	const char* view      = nullptr;
+	size_t      view_size = 0;
+
+	void        Unmap();
+};
+
+#endif /*! MAPPEDFILE_H_ */
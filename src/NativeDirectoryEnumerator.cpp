@@ -0,0 +1,126 @@
+#include "NativeDirectoryEnumerator.h"
+
+#ifdef __linux__
+
+#include "Debug.h"
+
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+	constexpr size_t LISTING_BUFFER_SIZE = 32 * 1024;
+
+	// Kernel record layout for getdents64, glibc only exposes it (as struct dirent64) behind _GNU_SOURCE and 2.30+
+	struct LinuxDirent64 {
+		uint64_t       d_ino;
+		int64_t        d_off;
+		unsigned short d_reclen;
+		unsigned char  d_type;
+		char           d_name[];
+	};
+
+	bool IsDotEntry(const char* name) {
+		return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+	}
+
+	// Same answer as path::extension() == ".cus", without building a path. A file named just ".cus" has no extension.
+	bool HasCusExtension(const char* name, size_t length) {
+		return length > 4 && std::memcmp(name + length - 4, ".cus", 4) == 0;
+	}
+
+	// d_type is DT_UNKNOWN on some filesystems, fall back to an lstat-style statx for those entries only
+	unsigned char ResolveType(int directory_fd, const char* name) {
+		struct statx stat_buf;
+		if (statx(directory_fd, name, AT_SYMLINK_NOFOLLOW | AT_STATX_SYNC_AS_STAT, STATX_TYPE, &stat_buf) != 0)
+			return DT_UNKNOWN;
+
+		if (S_ISDIR(stat_buf.stx_mode))
+			return DT_DIR;
+		if (S_ISREG(stat_buf.stx_mode))
+			return DT_REG;
+		if (S_ISLNK(stat_buf.stx_mode))
+			return DT_LNK;
+		return DT_UNKNOWN;
+	}
+} // namespace
+
+int NativeDirectoryEnumerator::OpenDirectory(const std::filesystem::path& path, std::error_code& error) noexcept {
+	return OpenSubdirectory(AT_FDCWD, path.c_str(), error);
+}
+
+int NativeDirectoryEnumerator::OpenSubdirectory(int parent_fd, const char* name, std::error_code& error) noexcept {
+	error.clear();
+	const int fd = openat(parent_fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOFOLLOW);
+	if (fd < 0) {
+		error = std::error_code(errno, std::generic_category());
+	}
+	return fd;
+}
+
+void NativeDirectoryEnumerator::Enumerate(int directory_fd, const std::filesystem::path& directory_path, const FileCallback& on_file, const DirectoryCallback& on_directory, std::error_code& error) {
+	error.clear();
+
+	// One listing buffer per thread, reused for every directory the thread walks
+	alignas(LinuxDirent64) thread_local char buffer[LISTING_BUFFER_SIZE];
+
+	while (true) {
+		const long bytes_read = syscall(SYS_getdents64, directory_fd, buffer, sizeof(buffer));
+		if (bytes_read < 0) {
+			if (errno == EINTR)
+				continue;
+			error = std::error_code(errno, std::generic_category());
+			return;
+		}
+		if (bytes_read == 0)
+			return;
+
+		for (long offset = 0; offset < bytes_read;) {
+			const auto* entry = reinterpret_cast<const LinuxDirent64*>(buffer + offset);
+			offset           += entry->d_reclen;
+
+			const char* name  = entry->d_name;
+			if (IsDotEntry(name))
+				continue;
+
+			unsigned char type = entry->d_type;
+			if (type == DT_UNKNOWN) {
+				type = ResolveType(directory_fd, name);
+			}
+
+			if (type == DT_DIR) {
+				if (on_directory) {
+					on_directory(name);
+				}
+				continue;
+			}
+
+			if (type != DT_REG && type != DT_LNK)
+				continue;
+
+			const size_t name_length = std::strlen(name);
+			if (!HasCusExtension(name, name_length))
+				continue;
+
+			// statx follows symlinks here, a link to a directory or a dangling link is dropped below
+			std::error_code stat_error;
+			FileInfo        info = FileInfo::ReadMetadataAt(directory_fd, name, stat_error);
+			if (stat_error) {
+				if (type == DT_REG) {
+					DEBUG_LOG("Could not stat " << (directory_path / name) << ": " << stat_error.message());
+				}
+				continue;
+			}
+			if (info.is_directory)
+				continue;
+
+			on_file(directory_path / std::string_view(name, name_length), std::move(info));
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef NATIVEDIRECTORYENUMERATOR_H_
+#define NATIVEDIRECTORYENUMERATOR_H_
+
+#ifdef __linux__
+
+#include "FileInfo.h"
+
+#include <filesystem>
+#include <functional>
+#include <system_error>
+
+/* Directory listing straight from getdents64 on an open directory descriptor. Entry types come from d_type, so only
+ * .cus files are stat'ed (with statx relative to the descriptor) and only they and subdirectories get a full path built. */
+namespace NativeDirectoryEnumerator {
+	using FileCallback      = std::function<void(std::filesystem::path&& path, FileInfo&& info)>;
+	using DirectoryCallback = std::function<void(const char* name)>; // Name relative to the directory being listed
+
+	int  OpenDirectory(const std::filesystem::path& path, std::error_code& error) noexcept;
+	int  OpenSubdirectory(int parent_fd, const char* name, std::error_code& error) noexcept;
+
+	// Reports regular .cus files (symlinks to them included, as is_regular_file would) and real subdirectories.
+	// Directory symlinks are never reported. Leave on_directory empty to list a single level. Does not close directory_fd.
+	// The listing buffer is per thread, so callbacks must not enumerate another directory on the same thread.
+	void Enumerate(int directory_fd, const std::filesystem::path& directory_path, const FileCallback& on_file, const DirectoryCallback& on_directory, std::error_code& error);
+} // namespace NativeDirectoryEnumerator
+
+#endif
+
+#endif /*! NATIVEDIRECTORYENUMERATOR_H_ */
@@ -115,6 +115,18 @@ namespace OperatingSystemFunctions {
 		return found_path;
 	}
 
+	static std::filesystem::path GetApplicationDataDirectory() {
+		std::filesystem::path base_directory;
+		if (const wchar_t* app_data = _wgetenv(L"APPDATA"); app_data && *app_data) {
+			base_directory = app_data;
+		} else {
+			std::error_code error;
+			base_directory = std::filesystem::temp_directory_path(error);
+		}
+
+		return base_directory / "PresetWeaver";
+	}
+
 	static std::string GetLocalizationRegion() {
 		wchar_t localeName[LOCALE_NAME_MAX_LENGTH];
 		if (!GetUserDefaultLocaleName(localeName, LOCALE_NAME_MAX_LENGTH)) {
@@ -0,0 +1,49 @@
+#include "PathArena.h"
+
+#include <algorithm>
+
+PathArena::PathView PathArena::Store(PathView path) {
+	const size_t needed = path.size() + 1;
+
+	PathChar*    destination;
+	if (needed > CHUNK_CHARACTERS) {
+		// Oversized paths get a chunk of their own and leave the current one open
+		chunks.push_back(std::make_unique<PathChar[]>(needed));
+		destination = chunks.back().get();
+	} else {
+		if (needed > remaining) {
+			chunks.push_back(std::make_unique<PathChar[]>(CHUNK_CHARACTERS));
+			cursor    = chunks.back().get();
+			remaining = CHUNK_CHARACTERS;
+		}
+		destination  = cursor;
+		cursor      += needed;
+		remaining   -= needed;
+	}
+
+	std::copy(path.begin(), path.end(), destination);
+	destination[path.size()]  = PathChar(0);
+	live_characters          += needed;
+	return PathView(destination, path.size());
+}
+
+void PathArena::Release(PathView path) {
+	live_characters -= path.size() + 1;
+	dead_characters += path.size() + 1;
+}
+
+void PathArena::Clear() {
+	chunks.clear();
+	cursor          = nullptr;
+	remaining       = 0;
+	live_characters = 0;
+	dead_characters = 0;
+}
+
+size_t PathArena::GetLiveCharacters() const {
+	return live_characters;
+}
+
+size_t PathArena::GetDeadCharacters() const {
+	return dead_characters;
+}
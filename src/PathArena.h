@@ -0,0 +1,40 @@
+#ifndef PATHARENA_H_
+#define PATHARENA_H_
+
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/* Append-only storage for native path strings. Each stored path is copied once, NUL-terminated, into a large chunk and
+ * never moves, so views into it stay valid until Clear(). Released paths only count as dead space; owners rebuild into a
+ * fresh arena once dead space dominates. */
+class PathArena {
+public:
+	using PathChar = std::filesystem::path::value_type;
+	using PathView = std::basic_string_view<PathChar>;
+
+	PathArena()                                    = default;
+	PathArena(PathArena&& other) noexcept          = default;
+	PathArena&           operator=(PathArena&& other) noexcept = default;
+	PathArena(const PathArena& other)              = delete;
+	PathArena&           operator=(const PathArena& other) = delete;
+
+	PathView             Store(PathView path);
+	void                 Release(PathView path);
+	void                 Clear();
+
+	[[nodiscard]] size_t GetLiveCharacters() const;
+	[[nodiscard]] size_t GetDeadCharacters() const;
+
+private:
+	static constexpr size_t                  CHUNK_CHARACTERS = 16 * 1024;
+
+	std::vector<std::unique_ptr<PathChar[]>> chunks;
+	PathChar*                                cursor          = nullptr;
+	size_t                                   remaining       = 0;
+	size_t                                   live_characters = 0;
+	size_t                                   dead_characters = 0;
+};
+
+#endif /*! PATHARENA_H_ */
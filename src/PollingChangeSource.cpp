@@ -0,0 +1,546 @@
+#include "PollingChangeSource.h"
+
+#include "Debug.h"
+#include "NativeDirectoryEnumerator.h"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+	// Last component of a record's path, still null terminated for the *at calls
+	const char* FileName(const FlatPathMapNode& node) {
+		const size_t separator = node.path.find_last_of('/');
+		return node.c_str() + (separator == PathArena::PathView::npos ? 0 : separator + 1);
+	}
+} // namespace
+#endif
+
+PollingChangeSource::PollingChangeSource(const std::filesystem::path& root_path, bool recurse_subdirectories, DirectoryScanOptions scan_options, const DirectoryMonitor::Seed* seed)
+    : root_path(root_path), recurse_subdirectories(recurse_subdirectories), native_enumeration(scan_options.native_enumeration), prune_unchanged_directories(scan_options.prune_unchanged_directories), carry_contents_limit(scan_options.carry_contents_limit) {
+	const unsigned thread_count = ThreadPool::ResolveThreadCount(scan_options.thread_count);
+	if (recurse_subdirectories && thread_count > 1) {
+		scan_pool = std::make_unique<ThreadPool>(thread_count);
+	}
+	worker_statistics.resize(scan_pool ? scan_pool->GetThreadCount() : 1);
+
+	root_directory = FindOrAddDirectory(root_path, nullptr);
+
+	if (seed) {
+		// The first scan then only stats, hashing just what changed since the seed was taken
+		for (const auto& [path, info] : seed->files) {
+			FileRecord* record = file_records.TryEmplace(path.native()).first;
+			record->info       = info;
+			record->unhashed   = info.content_hash == 0;
+			if (info.file_id != 0) {
+				records_by_file_id[info.file_id] = { record, info };
+			}
+		}
+		last_scan_time = seed->hashed_since;
+	}
+
+	Scan(nullptr);
+}
+
+size_t PollingChangeSource::GetFileCount() const {
+	return file_records.Size();
+}
+
+const char* PollingChangeSource::GetName() const {
+	return "polling";
+}
+
+bool PollingChangeSource::IsValid() const {
+	return true;
+}
+
+std::vector<std::filesystem::path> PollingChangeSource::GetKnownFiles() const {
+	std::vector<fs::path> files;
+	files.reserve(file_records.Size());
+	file_records.ForEach([&files](const FileRecord& record) {
+		files.emplace_back(record.path);
+	});
+	return files;
+}
+
+PollingChangeSource::ScanStatistics PollingChangeSource::GetLastScanStatistics() const {
+	return last_scan_statistics;
+}
+
+std::vector<DirectoryMonitor::ChangeInfo> PollingChangeSource::CollectChanges() {
+	std::vector<DirectoryMonitor::ChangeInfo> changes;
+	Scan(&changes);
+	return changes;
+}
+
+void PollingChangeSource::Reset() {
+	ClearRecords(); // Forces every file to be hashed and every directory to be listed again
+	Scan(nullptr);
+}
+
+void PollingChangeSource::ClearRecords() {
+	file_records.Clear();
+	directory_records.Clear();
+	records_by_file_id.clear();
+	discovered_files.clear();
+	read_contents.clear();
+	root_directory = FindOrAddDirectory(root_path, nullptr);
+}
+
+void PollingChangeSource::Scan(std::vector<DirectoryMonitor::ChangeInfo>* changes) {
+	// Hashes and listings are only trusted when written clearly before the previous scan started (git's "racily clean" rule)
+	racy_threshold             = last_scan_time - FileInfo::TIMESTAMP_GRANULARITY;
+	last_scan_time             = std::chrono::file_clock::now();
+	generation++;
+	keep_contents              = changes && carry_contents_limit > 0; // Nobody consumes the bytes of a baseline scan
+	root_directory->generation = generation; // The root anchors the walk and is kept even while it is missing
+
+	std::fill(worker_statistics.begin(), worker_statistics.end(), ScanStatistics {});
+	// The pool costs a task per directory and wakes every worker, only worth it for full scans (the first one and after a
+	// reset). A tick walks on the calling thread, so a quiet one stays free of allocations.
+	if (scan_pool && !changes) {
+		ScanParallel();
+	}
+#ifdef __linux__
+	else if (native_enumeration) {
+		ScanDirectoryAt(*root_directory, AT_FDCWD, root_directory->c_str(), worker_statistics.front());
+	}
+#endif
+	else {
+		ScanSequential();
+	}
+
+	Sweep(changes);
+
+	ScanStatistics statistics;
+	for (const auto& worker : worker_statistics) {
+		statistics.files_scanned      += worker.files_scanned;
+		statistics.hashes_computed    += worker.hashes_computed;
+		statistics.hashes_skipped     += worker.hashes_skipped;
+		statistics.directories_listed += worker.directories_listed;
+		statistics.directories_pruned += worker.directories_pruned;
+	}
+
+	last_scan_statistics = statistics;
+	if (statistics.hashes_computed > 0) {
+		DEBUG_LOG("Scan complete. Cached " << file_records.Size() << " items, hashed " << statistics.hashes_computed << ", skipped " << statistics.hashes_skipped << ".");
+	}
+}
+
+void PollingChangeSource::ScanSequential() {
+	pending_directories.clear();
+	pending_directories.push_back(root_directory);
+
+	while (!pending_directories.empty()) {
+		DirectoryRecord* directory = pending_directories.back();
+		pending_directories.pop_back();
+
+		if (ScanDirectoryRecord(*directory, worker_statistics.front())) {
+			pending_directories.insert(pending_directories.end(), directory->subdirectories.begin(), directory->subdirectories.end());
+		}
+	}
+}
+
+void PollingChangeSource::ScanParallel() {
+	// One task per directory. A task only writes the records of its own directory, the containers are locked just to add paths.
+	scan_pool->Submit([this]() {
+		ScanDirectoryTask(root_directory);
+	});
+	scan_pool->WaitIdle();
+}
+
+void PollingChangeSource::ScanDirectoryTask(DirectoryRecord* directory) {
+	if (!ScanDirectoryRecord(*directory, worker_statistics[scan_pool->CurrentWorkerIndex()]))
+		return;
+
+	for (DirectoryRecord* subdirectory : directory->subdirectories) {
+		scan_pool->Submit([this, subdirectory]() {
+			ScanDirectoryTask(subdirectory);
+		});
+	}
+}
+
+bool PollingChangeSource::ScanDirectoryRecord(DirectoryRecord& directory, ScanStatistics& statistics) {
+	std::error_code error;
+	FileInfo        info = FileInfo::ReadMetadata(directory.c_str(), error);
+	if (!AcceptDirectory(directory, info, error))
+		return false;
+
+	if (CanReuseListing(directory, info)) {
+		for (FileRecord* file : directory.files) {
+			ScanKnownFile(*file, statistics);
+		}
+		statistics.directories_pruned++;
+		return true;
+	}
+
+	directory.info = info;
+	ListDirectory(directory, statistics);
+	statistics.directories_listed++;
+	return true;
+}
+
+bool PollingChangeSource::AcceptDirectory(DirectoryRecord& directory, const FileInfo& info, const std::error_code& error) {
+	if (error || !info.is_directory) {
+		if (error) {
+			DEBUG_LOG("Could not stat " << fs::path(directory.path) << ": " << error.message());
+		}
+
+		// Nothing below is visited, so the sweep reports it all deleted
+		directory.files.clear();
+		directory.subdirectories.clear();
+		directory.info = FileInfo();
+		return false;
+	}
+
+	directory.generation = generation;
+	return true;
+}
+
+bool PollingChangeSource::CanReuseListing(const DirectoryRecord& directory, const FileInfo& info) const {
+	// Creating, removing or renaming an entry moves the directory's mtime, writing a file in place does not. A listing is
+	// reused under the same racily-clean rule as hashes, so an entry added in the mtime tick of the last listing is not missed.
+	return prune_unchanged_directories && info.HasSameMetadata(directory.info) && info.last_modified < racy_threshold;
+}
+
+#ifdef __linux__
+void PollingChangeSource::ScanDirectoryAt(DirectoryRecord& directory, int parent_fd, const char* name, ScanStatistics& statistics) {
+	// Stat'ed and opened relative to the parent while the parent is still open, so every call resolves a single component
+	std::error_code error;
+	FileInfo        info = FileInfo::ReadMetadataAt(parent_fd, name, error);
+	if (!AcceptDirectory(directory, info, error))
+		return;
+
+	const int directory_fd = NativeDirectoryEnumerator::OpenSubdirectory(parent_fd, name, error);
+	if (directory_fd < 0) {
+		// Same as a listing that could not be opened: nothing is known below it
+		DEBUG_LOG("Could not open " << fs::path(directory.path) << ": " << error.message());
+		directory.files.clear();
+		directory.subdirectories.clear();
+		directory.info              = FileInfo(); // Regaining access does not move the mtime, the next scan must list it again
+		directory.listed_generation = generation;
+		return;
+	}
+
+	if (CanReuseListing(directory, info)) {
+		for (FileRecord* file : directory.files) {
+			FileInfo file_info = FileInfo::ReadMetadataAt(directory_fd, FileName(*file), error);
+			if (!error && !file_info.is_directory) {
+				UpdateFileRecord(*file, std::move(file_info), statistics);
+			}
+		}
+		statistics.directories_pruned++;
+	} else {
+		directory.info = info;
+		ListDirectoryAt(directory, directory_fd, statistics);
+		statistics.directories_listed++;
+	}
+
+	for (DirectoryRecord* subdirectory : directory.subdirectories) {
+		ScanDirectoryAt(*subdirectory, directory_fd, FileName(*subdirectory), statistics);
+	}
+	close(directory_fd);
+}
+
+void PollingChangeSource::ListDirectoryAt(DirectoryRecord& directory, int directory_fd, ScanStatistics& statistics) {
+	const fs::path directory_path(directory.path);
+
+	directory.files.clear();
+	directory.subdirectories.clear();
+	directory.listed_generation = generation;
+
+	NativeDirectoryEnumerator::DirectoryCallback on_directory;
+	if (recurse_subdirectories) {
+		on_directory = [&](const char* name) {
+			directory.subdirectories.push_back(FindOrAddDirectory(directory_path / name, &directory));
+		};
+	}
+
+	std::error_code error;
+	NativeDirectoryEnumerator::Enumerate(
+	    directory_fd, directory_path,
+	    [&](fs::path&& path, FileInfo&& info) {
+		    ScanListedFile(directory, std::move(path), std::move(info), statistics);
+	    },
+	    on_directory, error);
+
+	if (error) {
+		DEBUG_LOG("Scan of " << directory_path << " stopped early: " << error.message());
+		directory.info = FileInfo(); // A partial listing is never reused
+	}
+}
+#endif
+
+void PollingChangeSource::ListDirectory(DirectoryRecord& directory, ScanStatistics& statistics) {
+	const fs::path  directory_path(directory.path);
+	std::error_code error;
+
+#ifdef __linux__
+	if (native_enumeration) {
+		// Pool tasks open by path, so queued work holds no descriptors
+		const int directory_fd = NativeDirectoryEnumerator::OpenDirectory(directory_path, error);
+		if (directory_fd < 0) {
+			DEBUG_LOG("Could not open " << directory_path << ": " << error.message());
+			directory.files.clear();
+			directory.subdirectories.clear();
+			directory.info              = FileInfo(); // Regaining access does not move the mtime, the next scan must list it again
+			directory.listed_generation = generation;
+			return;
+		}
+
+		ListDirectoryAt(directory, directory_fd, statistics);
+		close(directory_fd);
+		return;
+	}
+#endif
+
+	directory.files.clear();
+	directory.subdirectories.clear();
+	directory.listed_generation = generation;
+
+	// error_code overloads throughout, a file vanishing mid-scan is routine and must not unwind the scan
+	for (fs::directory_iterator iterator(directory_path, fs::directory_options::skip_permission_denied, error), end; !error && iterator != end; iterator.increment(error)) {
+		const fs::directory_entry& entry = *iterator;
+		std::error_code            status_error;
+
+		// Same traversal as recursive_directory_iterator: directory symlinks are not followed
+		if (entry.is_directory(status_error) && !entry.is_symlink(status_error)) {
+			if (recurse_subdirectories) {
+				directory.subdirectories.push_back(FindOrAddDirectory(entry.path(), &directory));
+			}
+			continue;
+		}
+
+		if (!entry.is_regular_file(status_error) || entry.path().extension() != ".cus")
+			continue;
+
+		FileInfo info = FileInfo::ReadMetadata(entry.path(), status_error);
+		if (status_error) {
+			DEBUG_LOG("Could not stat " << entry.path() << ": " << status_error.message());
+			continue;
+		}
+
+		ScanListedFile(directory, fs::path(entry.path()), std::move(info), statistics);
+	}
+
+	if (error) {
+		DEBUG_LOG("Scan of " << directory_path << " stopped early: " << error.message());
+		directory.info = FileInfo(); // A partial listing is never reused
+	}
+}
+
+void PollingChangeSource::ScanListedFile(DirectoryRecord& directory, std::filesystem::path&& path, FileInfo&& info, ScanStatistics& statistics) {
+	FileRecord* record;
+	{
+		std::lock_guard<std::mutex> lock(record_mutex);
+		record = file_records.TryEmplace(path.native()).first;
+	}
+
+	record->directory = &directory;
+	directory.files.push_back(record);
+	UpdateFileRecord(*record, std::move(info), statistics);
+}
+
+void PollingChangeSource::ScanKnownFile(FileRecord& record, ScanStatistics& statistics) {
+	std::error_code error;
+	FileInfo        info = FileInfo::ReadMetadata(record.c_str(), error);
+	if (error || info.is_directory)
+		return; // Left unvisited, the sweep reports it deleted and has its directory listed again
+
+	UpdateFileRecord(record, std::move(info), statistics);
+}
+
+void PollingChangeSource::UpdateFileRecord(FileRecord& record, FileInfo&& info, ScanStatistics& statistics) {
+	if (info.HasSameMetadata(record.info) && info.last_modified < racy_threshold && (record.info.content_hash != 0 || record.unhashed)) {
+		info.content_hash = record.info.content_hash;
+		statistics.hashes_skipped++;
+	} else if (info.file_id != record.info.file_id && ReuseMovedHash(info)) {
+		statistics.hashes_skipped++; // Renamed here untouched, so the sweep pairs it by content without a read
+	} else if (keep_contents && info.size <= carry_contents_limit) {
+		// Keep what was hashed, the consumer would otherwise read the file again
+		auto contents = std::make_shared<DirectoryMonitor::FileContents>();
+		info.UpdateHash(fs::path(record.path), contents->data);
+		contents->info  = info;
+		record.unhashed = false;
+		statistics.hashes_computed++;
+
+		if (info.content_hash != 0) {
+			std::lock_guard<std::mutex> lock(record_mutex);
+			read_contents[&record] = std::move(contents);
+		}
+	} else {
+		info.UpdateHash(fs::path(record.path));
+		record.unhashed = false;
+		statistics.hashes_computed++;
+	}
+
+	if (info.file_id != record.info.file_id) {
+		// A new path, or another file now sits at this one (saved through a temporary, or renamed over it)
+		std::lock_guard<std::mutex> lock(record_mutex);
+		auto                        previous = records_by_file_id.find(record.info.file_id);
+		if (previous != records_by_file_id.end() && previous->second.record == &record) {
+			records_by_file_id.erase(previous);
+		}
+
+		auto [holder, inserted] = records_by_file_id.try_emplace(info.file_id, FileIdHolder { &record, info });
+		if (!inserted) {
+			record.moved_from = holder->second.record;
+			holder->second    = { &record, info };
+		}
+
+		record.is_new_path = record.info.file_id == 0;
+		discovered_files.push_back(&record);
+	} else if (info != record.info) {
+		record.modified = true;
+
+		std::lock_guard<std::mutex> lock(record_mutex);
+		auto                        holder = records_by_file_id.find(info.file_id);
+		if (holder != records_by_file_id.end() && holder->second.record == &record) {
+			holder->second.info = info;
+		}
+	}
+
+	record.info       = info;
+	record.generation = generation;
+	statistics.files_scanned++;
+}
+
+bool PollingChangeSource::ReuseMovedHash(FileInfo& info) {
+	// The file_id's last holder was hashed with this exact metadata, under the same racily-clean rule as a path's own hash
+	if (info.last_modified >= racy_threshold)
+		return false;
+
+	std::lock_guard<std::mutex> lock(record_mutex);
+	const auto                  holder = records_by_file_id.find(info.file_id);
+	if (holder == records_by_file_id.end() || holder->second.info.content_hash == 0 || !holder->second.info.HasSameMetadata(info))
+		return false;
+
+	info.content_hash = holder->second.info.content_hash;
+	return true;
+}
+
+PollingChangeSource::DirectoryRecord* PollingChangeSource::FindOrAddDirectory(const std::filesystem::path& path, DirectoryRecord* parent) {
+	std::lock_guard<std::mutex> lock(record_mutex);
+	DirectoryRecord*            directory = directory_records.TryEmplace(path.native()).first;
+	directory->parent                     = parent;
+	return directory;
+}
+
+void PollingChangeSource::Sweep(std::vector<DirectoryMonitor::ChangeInfo>* changes) {
+	using ChangeInfo = DirectoryMonitor::ChangeInfo;
+
+	// New or replaced paths first: when the previous holder of the file_id was not seen this scan, the file was renamed.
+	// Consumers move a renamed entry without reading it, so the contents must match too. A freed inode can be reused at once.
+	// A seeded file never hashed has only its metadata to match, the same trust the seed got on the first scan.
+	for (FileRecord* record : discovered_files) {
+		FileRecord* source = record->moved_from;
+		record->moved_from = nullptr;
+
+		const bool same_file = source && (source->info.HasSameContent(record->info) || (source->unhashed && source->info.HasSameMetadata(record->info)));
+		if (same_file && source->generation != generation && !source->moved_away) {
+			source->moved_away = true;
+			if (changes) {
+				changes->push_back({ ChangeInfo::RENAMED, fs::path(record->path), fs::path(source->path), nullptr });
+			}
+		} else if (record->is_new_path && record->info.content_hash != 0) {
+			unmatched_additions.push_back(record); // Reported once the deletions are known
+			continue;
+		} else if (changes) {
+			changes->push_back({ record->is_new_path ? ChangeInfo::ADDED : ChangeInfo::MODIFIED, fs::path(record->path), {}, TakeContents(record) });
+		}
+		record->is_new_path = false;
+	}
+	discovered_files.clear();
+
+	// Saving through a temporary or copying then deleting gives the file a new file_id, pair those by content instead
+	std::sort(unmatched_additions.begin(), unmatched_additions.end(), [](const FileRecord* left, const FileRecord* right) {
+		return left->info.content_hash < right->info.content_hash;
+	});
+
+	file_records.EraseIf([&](FileRecord& record) {
+		if (record.generation == generation) {
+			if (record.modified && changes) {
+				changes->push_back({ ChangeInfo::MODIFIED, fs::path(record.path), {}, TakeContents(&record) });
+			}
+			record.modified = false;
+			return false;
+		}
+
+		if (!record.moved_away) {
+			FileRecord* match = TakeContentMatch(record.info);
+			if (match && changes) {
+				changes->push_back({ ChangeInfo::RENAMED, fs::path(match->path), fs::path(record.path), nullptr });
+			} else if (changes) {
+				changes->push_back({ ChangeInfo::DELETED, fs::path(record.path), {}, nullptr });
+			}
+		}
+
+		// Gone from a directory whose listing was reused, so that listing is stale
+		DirectoryRecord* directory = record.directory;
+		if (directory && directory->generation == generation && directory->listed_generation != generation) {
+			directory->info.file_id = 0;
+		}
+
+		auto indexed = records_by_file_id.find(record.info.file_id);
+		if (indexed != records_by_file_id.end() && indexed->second.record == &record) {
+			records_by_file_id.erase(indexed);
+		}
+		return true;
+	});
+
+	for (FileRecord* record : unmatched_additions) {
+		if (record->is_new_path && changes) {
+			changes->push_back({ ChangeInfo::ADDED, fs::path(record->path), {}, TakeContents(record) });
+		}
+		record->is_new_path = false;
+	}
+	unmatched_additions.clear();
+
+	directory_records.ForEach([this](DirectoryRecord& directory) {
+		DirectoryRecord* parent = directory.parent;
+		if (directory.generation != generation && parent && parent->generation == generation && parent->listed_generation != generation) {
+			parent->info.file_id = 0;
+		}
+	});
+
+	directory_records.EraseIf([this](const DirectoryRecord& directory) {
+		return directory.generation != generation;
+	});
+
+	read_contents.clear(); // Hashed again without a change to report, or the record is gone
+
+	// Renames and deletions leave dead path strings behind, rebuilt here while no scan holds a record
+	file_records.CompactPaths();
+	directory_records.CompactPaths();
+}
+
+PollingChangeSource::ContentsPointer PollingChangeSource::TakeContents(const FileRecord* record) {
+	auto found = read_contents.find(record);
+	if (found == read_contents.end())
+		return nullptr;
+
+	auto contents = std::move(found->second);
+	read_contents.erase(found);
+	return contents;
+}
+
+PollingChangeSource::FileRecord* PollingChangeSource::TakeContentMatch(const FileInfo& deleted) {
+	if (deleted.content_hash == 0)
+		return nullptr;
+
+	auto candidate = std::lower_bound(unmatched_additions.begin(), unmatched_additions.end(), deleted.content_hash, [](const FileRecord* record, uint64_t hash) {
+		return record->info.content_hash < hash;
+	});
+
+	for (; candidate != unmatched_additions.end() && (*candidate)->info.content_hash == deleted.content_hash; ++candidate) {
+		FileRecord* record = *candidate;
+		if (record->is_new_path && record->info.size == deleted.size) {
+			record->is_new_path = false; // Taken, no longer reported as an addition
+			return record;
+		}
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,120 @@
+#ifndef POLLINGCHANGESOURCE_H_
+#define POLLINGCHANGESOURCE_H_
+
+#include "DirectoryMonitor.h"
+#include "FileInfo.h"
+#include "FlatPathMap.h"
+#include "ThreadPool.h"
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/* Fallback backend: rescans the tree on every call and diffs it against what the previous scan saw.
+ * State lives in place between scans, one record per file and per directory stamped with the generation of the last scan
+ * that reached it, plus a file_id index for pairing renames. Records sit in flat path maps with their paths interned once. A scan updates the records it reaches and a sweep drops the
+ * rest as deleted, so a scan that finds nothing new does not allocate. A deleted and an added path with the same content
+ * hash and size in one scan are reported as a rename, which covers saves through a temporary and copy-then-delete moves.
+ * Files whose (file_id, size, mtime) are unchanged keep their cached hash, so a quiet tree costs one stat per file.
+ * Small files that are hashed keep the bytes they were hashed from and hand them out with their change, so they are read once.
+ * Directories whose own (file_id, mtime) are unchanged still hold the entries they were listed with, so they are not
+ * listed again, only their known files are stat'ed. Scan cost then follows the directories that changed.
+ * With more than one scan thread, full scans spread directories over a work-stealing pool, ticks walk sequentially.
+ * On Linux listings can go through NativeDirectoryEnumerator, which skips the stat for everything that is not a .cus file.
+ * A sequential native scan then walks with descriptors, opening and stat'ing everything relative to an open directory. */
+class PollingChangeSource final : public DirectoryMonitor::ChangeSource {
+public:
+	using ScanStatistics = DirectoryMonitor::ScanStatistics;
+
+	PollingChangeSource(const std::filesystem::path& root_path, bool recurse_subdirectories, DirectoryScanOptions scan_options = {}, const DirectoryMonitor::Seed* seed = nullptr);
+
+	std::vector<DirectoryMonitor::ChangeInfo>        CollectChanges() override;
+	[[nodiscard]] size_t                             GetFileCount() const override;
+	void                                             Reset() override;
+	[[nodiscard]] const char*                        GetName() const override;
+	[[nodiscard]] bool                               IsValid() const override; // A rescan sees everything, always
+	[[nodiscard]] std::vector<std::filesystem::path> GetKnownFiles() const override;
+	[[nodiscard]] ScanStatistics                     GetLastScanStatistics() const override;
+
+private:
+	using ContentsPointer = std::shared_ptr<const DirectoryMonitor::FileContents>;
+
+	struct DirectoryRecord;
+
+	struct FileRecord : FlatPathMapNode {
+		FileInfo         info;
+		DirectoryRecord* directory   = nullptr; // Directory that listed it, null for seeded files not yet listed
+		FileRecord*      moved_from  = nullptr; // Earlier holder of the file_id this path took during the current scan
+		uint32_t         generation  = 0;
+		bool             is_new_path = false;   // Path first seen during the current scan
+		bool             modified    = false;   // Contents changed during the current scan
+		bool             moved_away  = false;   // Already reported as the old path of a rename
+		bool             unhashed    = false;   // Seeded without a hash, trusted on its metadata until that changes
+	};
+
+	struct DirectoryRecord : FlatPathMapNode {
+		FileInfo                      info; // As of the last listing, file_id 0 forces the next scan to list it
+		DirectoryRecord*              parent            = nullptr;
+		std::vector<FileRecord*>      files;
+		std::vector<DirectoryRecord*> subdirectories;
+		uint32_t                      generation        = 0;
+		uint32_t                      listed_generation = 0;
+	};
+
+	/* Last record to take a file_id, with the file's metadata and hash as of then, read without touching the record */
+	struct FileIdHolder {
+		FileRecord* record;
+		FileInfo    info;
+	};
+
+	std::filesystem::path                                      root_path;
+	bool                                                       recurse_subdirectories;
+	bool                                                       native_enumeration;
+	bool                                                       prune_unchanged_directories;
+	uintmax_t                                                  carry_contents_limit;
+	bool                                                       keep_contents = false;
+
+	FlatPathMap<FileRecord>                                    file_records;
+	FlatPathMap<DirectoryRecord>                               directory_records;
+	std::unordered_map<uint64_t, FileIdHolder>                 records_by_file_id;
+	std::vector<FileRecord*>                                   discovered_files;    // Paths that appeared or changed file_id this scan
+	std::vector<FileRecord*>                                   unmatched_additions; // New paths without a file_id match, sorted by content hash
+	std::unordered_map<const FileRecord*, ContentsPointer>     read_contents;       // Bytes hashed this scan, handed out with its change
+	std::mutex                                                 record_mutex;     // Guards the containers above during a pooled scan
+	DirectoryRecord*                                           root_directory = nullptr;
+
+	uint32_t                                                   generation     = 0;
+	std::chrono::time_point<std::chrono::file_clock>           last_scan_time;
+	std::chrono::time_point<std::chrono::file_clock>           racy_threshold;
+	std::vector<DirectoryRecord*>                              pending_directories; // Sequential walk stack, kept for its capacity
+	std::vector<ScanStatistics>                                worker_statistics;
+	ScanStatistics                                             last_scan_statistics;
+	std::unique_ptr<ThreadPool>                                scan_pool;
+
+	void                                                       Scan(std::vector<DirectoryMonitor::ChangeInfo>* changes);
+	void                                                       ScanSequential();
+	void                                                       ScanParallel();
+	void                                                       ScanDirectoryTask(DirectoryRecord* directory);
+	bool                                                       ScanDirectoryRecord(DirectoryRecord& directory, ScanStatistics& statistics);
+	bool                                                       AcceptDirectory(DirectoryRecord& directory, const FileInfo& info, const std::error_code& error);
+	[[nodiscard]] bool                                         CanReuseListing(const DirectoryRecord& directory, const FileInfo& info) const;
+	void                                                       ListDirectory(DirectoryRecord& directory, ScanStatistics& statistics);
+#ifdef __linux__
+	// Sequential walk with descriptors: each directory relative to its parent's, each file relative to its directory's
+	void                                                       ScanDirectoryAt(DirectoryRecord& directory, int parent_fd, const char* name, ScanStatistics& statistics);
+	void                                                       ListDirectoryAt(DirectoryRecord& directory, int directory_fd, ScanStatistics& statistics);
+#endif
+	void                                                       ScanListedFile(DirectoryRecord& directory, std::filesystem::path&& path, FileInfo&& info, ScanStatistics& statistics);
+	void                                                       ScanKnownFile(FileRecord& record, ScanStatistics& statistics);
+	void                                                       UpdateFileRecord(FileRecord& record, FileInfo&& info, ScanStatistics& statistics);
+	bool                                                       ReuseMovedHash(FileInfo& info);
+	DirectoryRecord*                                           FindOrAddDirectory(const std::filesystem::path& path, DirectoryRecord* parent);
+	void                                                       Sweep(std::vector<DirectoryMonitor::ChangeInfo>* changes);
+	ContentsPointer                                            TakeContents(const FileRecord* record);
+	FileRecord*                                                TakeContentMatch(const FileInfo& deleted);
+	void                                                       ClearRecords();
+};
+
+#endif /*! POLLINGCHANGESOURCE_H_ */
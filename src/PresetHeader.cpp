@@ -0,0 +1,105 @@
+#include "PresetHeader.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool PresetHeader::Read(const std::filesystem::path& filepath, Bytes& header) {
+#ifdef _WIN32
+	HANDLE hFile = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	OVERLAPPED at_start {};
+	DWORD      read      = 0;
+	const BOOL succeeded = ReadFile(hFile, header.data(), static_cast<DWORD>(SIZE), &read, &at_start);
+	CloseHandle(hFile);
+	return succeeded && read == SIZE;
+#else
+	const int fd = open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+
+	const ssize_t read = pread(fd, header.data(), SIZE, 0);
+	close(fd);
+	return read == static_cast<ssize_t>(SIZE);
+#endif
+}
+
+PresetHeader::WriteStatus PresetHeader::WriteRegion(const std::filesystem::path& filepath, const FileInfo& expected, std::string_view region, FileInfo& written, std::error_code& error) {
+	error.clear();
+	if (region.size() != REGION_LENGTH || expected.size < SIZE) {
+		error = std::make_error_code(std::errc::invalid_argument);
+		return WriteStatus::FAILED;
+	}
+
+	// Nothing is written over a file that changed since it was loaded, the monitor will report it instead
+	const FileInfo current = FileInfo::ReadMetadata(filepath, error);
+	if (error) {
+		return WriteStatus::FAILED;
+	}
+	if (!current.HasSameMetadata(expected)) {
+		return WriteStatus::FILE_CHANGED;
+	}
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileW(filepath.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		error = std::error_code(static_cast<int>(GetLastError()), std::system_category());
+		return WriteStatus::FAILED;
+	}
+
+	// The path could have been swapped between the check and the open, so compare the identity of what was opened
+	WriteStatus                status = WriteStatus::WRITTEN;
+	BY_HANDLE_FILE_INFORMATION file_information;
+	if (!GetFileInformationByHandle(hFile, &file_information)) {
+		error  = std::error_code(static_cast<int>(GetLastError()), std::system_category());
+		status = WriteStatus::FAILED;
+	} else if (((static_cast<uint64_t>(file_information.nFileIndexHigh) << 32) | file_information.nFileIndexLow) != expected.file_id) {
+		status = WriteStatus::FILE_CHANGED;
+	} else {
+		OVERLAPPED at_region {};
+		at_region.Offset = static_cast<DWORD>(REGION_OFFSET);
+		DWORD wrote      = 0;
+		if (!WriteFile(hFile, region.data(), static_cast<DWORD>(REGION_LENGTH), &wrote, &at_region) || wrote != REGION_LENGTH) {
+			error  = std::error_code(static_cast<int>(GetLastError()), std::system_category());
+			status = WriteStatus::FAILED;
+		}
+	}
+	CloseHandle(hFile);
+#else
+	const int fd = open(filepath.c_str(), O_WRONLY | O_CLOEXEC);
+	if (fd < 0) {
+		error = std::error_code(errno, std::generic_category());
+		return WriteStatus::FAILED;
+	}
+
+	// The path could have been swapped between the check and the open, so compare the identity of what was opened
+	WriteStatus status = WriteStatus::WRITTEN;
+	struct stat stat_buf;
+	if (fstat(fd, &stat_buf) != 0) {
+		error  = std::error_code(errno, std::generic_category());
+		status = WriteStatus::FAILED;
+	} else if (((static_cast<uint64_t>(stat_buf.st_dev) << 32) | stat_buf.st_ino) != expected.file_id) {
+		status = WriteStatus::FILE_CHANGED;
+	} else if (const ssize_t wrote = pwrite(fd, region.data(), REGION_LENGTH, REGION_OFFSET); wrote != static_cast<ssize_t>(REGION_LENGTH)) {
+		error  = wrote < 0 ? std::error_code(errno, std::generic_category()) : std::make_error_code(std::errc::io_error);
+		status = WriteStatus::FAILED;
+	}
+	close(fd);
+#endif
+
+	if (status != WriteStatus::WRITTEN) {
+		return status;
+	}
+
+	written = FileInfo::ReadMetadata(filepath, error);
+	return error ? WriteStatus::FAILED : WriteStatus::WRITTEN;
+}
@@ -0,0 +1,33 @@
+#ifndef PRESETHEADER_H_
+#define PRESETHEADER_H_
+
+#include "FileInfo.h"
+
+#include <array>
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+/* Positional access to the fixed header of a .cus preset. Only these bytes are ever read or patched, the body is left alone. */
+namespace PresetHeader {
+	constexpr size_t SIZE          = 0x0B;
+	constexpr size_t REGION_OFFSET = 0x08;
+	constexpr size_t REGION_LENGTH = 3;
+
+	using Bytes                    = std::array<char, SIZE>;
+
+	enum class WriteStatus {
+		WRITTEN,
+		FILE_CHANGED, // No longer the file described by expected, nothing was written
+		FAILED        // See the error code
+	};
+
+	// Reads the first SIZE bytes. Fails for files shorter than the header.
+	bool        Read(const std::filesystem::path& filepath, Bytes& header);
+
+	// Writes the region bytes in place, only if the file is still the one described by expected (file_id, size, mtime).
+	// Once written, written holds the metadata after the write, without a hash.
+	WriteStatus WriteRegion(const std::filesystem::path& filepath, const FileInfo& expected, std::string_view region, FileInfo& written, std::error_code& error);
+}
+
+#endif /*! PRESETHEADER_H_ */
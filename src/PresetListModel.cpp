@@ -0,0 +1,160 @@
+#include "PresetListModel.h"
+
+#include <utility>
+
+PresetListModel::PresetListModel(std::vector<std::string> region_names) {
+	regions.reserve(region_names.size());
+	for (std::string& region : region_names) {
+		slint::SharedString region_string(region);
+		regions.push_back({ std::move(region), std::move(region_string) });
+	}
+}
+
+size_t PresetListModel::row_count() const {
+	return total_rows;
+}
+
+std::optional<SlintCusFile> PresetListModel::row_data(size_t row) const {
+	for (const ShownRegion& shown : regions) {
+		const size_t count = shown.files ? shown.files->size : 0;
+		if (row >= count) {
+			row -= count;
+			continue;
+		}
+
+		const CusFileSnapshot::File& file = shown.files->At(row);
+		auto [path, inserted]             = path_strings.try_emplace(file.serial);
+		if (inserted) {
+			path->second = slint::SharedString(file.relative_path.string());
+		}
+
+		return SlintCusFile { .path = path->second, .region = shown.region_string, .data_size = static_cast<int>(file.info.size), .invalid = file.invalid };
+	}
+
+	return std::nullopt;
+}
+
+void PresetListModel::Update(std::shared_ptr<const CusFileSnapshot> next) {
+	if (next == snapshot)
+		return;
+
+	std::erase_if(views, [](const std::weak_ptr<PresetRegionView>& view) {
+		return view.expired();
+	});
+
+	// The previous snapshot stays alive until the diff is done, its regions are what the rows showed
+	const std::shared_ptr<const CusFileSnapshot> previous = std::exchange(snapshot, std::move(next));
+
+	size_t row = 0;
+	for (size_t region_index = 0; region_index < regions.size(); ++region_index) {
+		ShownRegion&                   shown   = regions[region_index];
+		const CusFileSnapshot::Region* current = snapshot->FindRegion(shown.region);
+		row                                    = DiffRegion(region_index, row, shown.files, current);
+		shown.files                            = current;
+	}
+}
+
+size_t PresetListModel::GetRegionIndex(std::string_view region) const {
+	for (size_t region_index = 0; region_index < regions.size(); ++region_index) {
+		if (regions[region_index].region == region)
+			return region_index;
+	}
+	return regions.size();
+}
+
+size_t PresetListModel::GetRowCount(size_t region_index) const {
+	if (region_index >= regions.size() || !regions[region_index].files)
+		return 0;
+
+	return regions[region_index].files->size;
+}
+
+size_t PresetListModel::GetFirstRow(size_t region_index) const {
+	size_t first_row = 0;
+	for (size_t index = 0; index < region_index && index < regions.size(); ++index) {
+		first_row += GetRowCount(index);
+	}
+	return first_row;
+}
+
+void PresetListModel::NotifyRow(PresetRegionView::RowEvent event, size_t region_index, size_t row) {
+	switch (event) {
+	case PresetRegionView::RowEvent::ADDED:
+		notify_row_added(row, 1);
+		break;
+	case PresetRegionView::RowEvent::REMOVED:
+		notify_row_removed(row, 1);
+		break;
+	case PresetRegionView::RowEvent::CHANGED:
+		notify_row_changed(row);
+		break;
+	}
+
+	for (const std::weak_ptr<PresetRegionView>& view : views) {
+		if (const std::shared_ptr<PresetRegionView> live = view.lock()) {
+			live->OnSourceRow(event, region_index, row);
+		}
+	}
+}
+
+size_t PresetListModel::DiffRegion(size_t region_index, size_t row, const CusFileSnapshot::Region* previous, const CusFileSnapshot::Region* current) {
+	using Chunks = std::vector<std::shared_ptr<const CusFileSnapshot::Chunk>>;
+	static const Chunks no_chunks;
+	const Chunks&       old_chunks = previous ? previous->chunks : no_chunks;
+	const Chunks&       new_chunks = current ? current->chunks : no_chunks;
+	if (previous == current)
+		return row + (current ? current->size : 0);
+
+	// Files only join a region at its tail, so the survivors keep their order and every file that joined since comes after
+	// them: walking both lists at once, an old file that does not line up with the new one was removed. A chunk both
+	// snapshots share is skipped whole. Rows are counted as the notifications are sent, each one applies to the list as
+	// the previous ones left it.
+	size_t     old_chunk  = 0;
+	size_t     old_offset = 0;
+	size_t     new_chunk  = 0;
+	size_t     new_offset = 0;
+	const auto advance    = [](const Chunks& chunks, size_t& chunk, size_t& offset) {
+		if (++offset == chunks[chunk]->size()) {
+			chunk++;
+			offset = 0;
+		}
+	};
+
+	while (old_chunk < old_chunks.size() || new_chunk < new_chunks.size()) {
+		const bool old_left = old_chunk < old_chunks.size();
+		const bool new_left = new_chunk < new_chunks.size();
+		if (old_left && new_left && old_offset == 0 && new_offset == 0 && old_chunks[old_chunk] == new_chunks[new_chunk]) {
+			row += new_chunks[new_chunk]->size();
+			old_chunk++;
+			new_chunk++;
+			continue;
+		}
+
+		const CusFileSnapshot::File* old_file = old_left ? &(*old_chunks[old_chunk])[old_offset] : nullptr;
+		const CusFileSnapshot::File* new_file = new_left ? &(*new_chunks[new_chunk])[new_offset] : nullptr;
+
+		if (old_file && new_file && old_file->serial == new_file->serial) {
+			if (old_file->relative_path.native() != new_file->relative_path.native()) {
+				path_strings.erase(old_file->serial); // Renamed
+				NotifyRow(PresetRegionView::RowEvent::CHANGED, region_index, row);
+			} else if (old_file->info.size != new_file->info.size || old_file->invalid != new_file->invalid) {
+				NotifyRow(PresetRegionView::RowEvent::CHANGED, region_index, row);
+			}
+			advance(old_chunks, old_chunk, old_offset);
+			advance(new_chunks, new_chunk, new_offset);
+			row++;
+		} else if (old_file) {
+			path_strings.erase(old_file->serial);
+			total_rows--;
+			NotifyRow(PresetRegionView::RowEvent::REMOVED, region_index, row);
+			advance(old_chunks, old_chunk, old_offset);
+		} else {
+			total_rows++;
+			NotifyRow(PresetRegionView::RowEvent::ADDED, region_index, row);
+			advance(new_chunks, new_chunk, new_offset);
+			row++;
+		}
+	}
+
+	return row;
+}
@@ -0,0 +1,51 @@
+#ifndef PRESETLISTMODEL_H_
+#define PRESETLISTMODEL_H_
+
+#include "CusFileStore.h"
+#include "PresetRegionView.h"
+
+#include <app-window.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/* The presets of some regions, read straight from a store snapshot and grouped by region in the order given. Nothing is
+ * copied per row: a row is built only when Slint asks for it, from a path string cached per file. Moving to a newer
+ * snapshot diffs the regions that changed, skipping the chunks they still share, and notifies only the rows that were
+ * added, removed or changed, here and in every PresetRegionView over this model. UI thread only. */
+class PresetListModel : public slint::Model<SlintCusFile> {
+public:
+	explicit PresetListModel(std::vector<std::string> region_names); // Shown in this order
+
+	[[nodiscard]] size_t                      row_count() const override;
+	[[nodiscard]] std::optional<SlintCusFile> row_data(size_t row) const override;
+
+	void                                      Update(std::shared_ptr<const CusFileSnapshot> snapshot);
+
+	// Position of a region in the row order, the region count for one not shown
+	[[nodiscard]] size_t                      GetRegionIndex(std::string_view region) const;
+	[[nodiscard]] size_t                      GetRowCount(size_t region_index) const; // Files in the region, kept as the snapshot's own count
+	[[nodiscard]] size_t                      GetFirstRow(size_t region_index) const;
+
+private:
+	friend class PresetRegionView;
+
+	struct ShownRegion {
+		std::string                    region;
+		slint::SharedString            region_string;
+		const CusFileSnapshot::Region* files = nullptr; // Owned by snapshot, null while the region has no files
+	};
+
+	std::vector<ShownRegion>                                         regions;
+	std::shared_ptr<const CusFileSnapshot>                           snapshot;
+	size_t                                                           total_rows = 0;
+	mutable std::unordered_map<uint64_t, slint::SharedString>        path_strings; // By CusFile::serial, dropped when the row goes
+	std::vector<std::weak_ptr<PresetRegionView>>                     views;
+
+	void                                                             NotifyRow(PresetRegionView::RowEvent event, size_t region_index, size_t row);
+	size_t                                                           DiffRegion(size_t region_index, size_t row, const CusFileSnapshot::Region* previous, const CusFileSnapshot::Region* current);
+};
+
+#endif /*! PRESETLISTMODEL_H_ */
@@ -0,0 +1,49 @@
+#include "PresetRegionView.h"
+
+#include "PresetListModel.h"
+
+#include <utility>
+
+std::shared_ptr<PresetRegionView> PresetRegionView::Create(std::shared_ptr<PresetListModel> source, std::string_view excluded_region) {
+	const size_t                      region_index = source->GetRegionIndex(excluded_region);
+	std::shared_ptr<PresetRegionView> view(new PresetRegionView(source, region_index));
+	source->views.push_back(view);
+	return view;
+}
+
+PresetRegionView::PresetRegionView(std::shared_ptr<const PresetListModel> source, size_t excluded_region_index)
+    : source(std::move(source)),
+      excluded_region_index(excluded_region_index) {
+}
+
+size_t PresetRegionView::row_count() const {
+	return source->row_count() - source->GetRowCount(excluded_region_index);
+}
+
+std::optional<SlintCusFile> PresetRegionView::row_data(size_t row) const {
+	const size_t first_excluded = source->GetFirstRow(excluded_region_index);
+	return source->row_data(row < first_excluded ? row : row + source->GetRowCount(excluded_region_index));
+}
+
+size_t PresetRegionView::GetExcludedRegionIndex() const {
+	return excluded_region_index;
+}
+
+void PresetRegionView::OnSourceRow(RowEvent event, size_t region_index, size_t source_row) {
+	if (region_index == excluded_region_index)
+		return;
+
+	// Regions are diffed in order, so an excluded region before this one already has its new row count
+	const size_t view_row = region_index > excluded_region_index ? source_row - source->GetRowCount(excluded_region_index) : source_row;
+	switch (event) {
+	case RowEvent::ADDED:
+		notify_row_added(view_row, 1);
+		break;
+	case RowEvent::REMOVED:
+		notify_row_removed(view_row, 1);
+		break;
+	case RowEvent::CHANGED:
+		notify_row_changed(view_row);
+		break;
+	}
+}
@@ -0,0 +1,41 @@
+#ifndef PRESETREGIONVIEW_H_
+#define PRESETREGIONVIEW_H_
+
+#include <app-window.h>
+#include <memory>
+#include <string_view>
+
+class PresetListModel;
+
+/* The rows of a PresetListModel outside one region. The model keeps its rows grouped by region, so the view is the model
+ * with one block of rows cut out: an index maps across by an offset and nothing is copied. The model forwards its row
+ * notifications to every live view, so showing another region is only a matter of handing the UI another view. */
+class PresetRegionView : public slint::Model<SlintCusFile> {
+public:
+	// Registers the view with source. Excluding a region the source does not show leaves every row in.
+	static std::shared_ptr<PresetRegionView> Create(std::shared_ptr<PresetListModel> source, std::string_view excluded_region);
+
+	[[nodiscard]] size_t                      row_count() const override;
+	[[nodiscard]] std::optional<SlintCusFile> row_data(size_t row) const override;
+
+	[[nodiscard]] size_t                      GetExcludedRegionIndex() const;
+
+private:
+	friend class PresetListModel;
+
+	enum class RowEvent {
+		ADDED,
+		REMOVED,
+		CHANGED
+	};
+
+	std::shared_ptr<const PresetListModel> source;
+	size_t                                 excluded_region_index;
+
+	PresetRegionView(std::shared_ptr<const PresetListModel> source, size_t excluded_region_index);
+
+	// Passes on a notification of the source, unless it is about a row of the excluded region
+	void                                   OnSourceRow(RowEvent event, size_t region_index, size_t source_row);
+};
+
+#endif /*! PRESETREGIONVIEW_H_ */
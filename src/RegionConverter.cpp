@@ -0,0 +1,89 @@
+#include "RegionConverter.h"
+
+double RegionConverter::Statistics::FilesPerSecond(std::chrono::microseconds stage_time) const {
+	if (stage_time.count() <= 0)
+		return 0.0;
+
+	return static_cast<double>(written) * 1e6 / static_cast<double>(stage_time.count());
+}
+
+RegionConverter::RegionConverter(unsigned io_concurrency)
+    : io_concurrency(ThreadPool::ResolveThreadCount(io_concurrency)) {
+}
+
+void RegionConverter::SetConcurrency(unsigned io_concurrency) {
+	this->io_concurrency.store(ThreadPool::ResolveThreadCount(io_concurrency), std::memory_order_relaxed);
+}
+
+unsigned RegionConverter::GetConcurrency() const {
+	return io_concurrency.load(std::memory_order_relaxed);
+}
+
+RegionConverter::Progress RegionConverter::GetProgress() const {
+	Progress progress;
+	progress.done                 = files_done.load(std::memory_order_relaxed);
+	progress.total                = files_total.load(std::memory_order_relaxed);
+
+	const Clock::rep      end     = write_end.load();
+	const Clock::duration elapsed = Clock::duration((end ? end : Clock::now().time_since_epoch().count()) - write_start.load());
+	if (elapsed.count() > 0) {
+		progress.files_per_second = static_cast<double>(progress.done) / std::chrono::duration<double>(elapsed).count();
+	}
+	return progress;
+}
+
+void RegionConverter::Write(std::vector<Job>& jobs, std::string_view region, const std::atomic<bool>& cancelled) {
+	write_end   = 0;
+	write_start = Clock::now().time_since_epoch().count();
+	files_done  = 0;
+	files_total = jobs.size();
+
+	WriteAll(jobs, region, cancelled);
+
+	write_end = Clock::now().time_since_epoch().count();
+}
+
+void RegionConverter::WriteAll(std::vector<Job>& jobs, std::string_view region, const std::atomic<bool>& cancelled) {
+	// A change made while this batch is written applies from the next one
+	const unsigned concurrency = io_concurrency.load(std::memory_order_relaxed);
+	if (concurrency <= 1 || jobs.size() < INLINE_BATCH) {
+		for (Job& job : jobs) {
+			WriteJob(job, region, cancelled);
+		}
+		return;
+	}
+
+	if (!pool || pool->GetThreadCount() != concurrency) {
+		pool = std::make_unique<ThreadPool>(concurrency);
+	}
+
+	// One puller per worker keeps exactly concurrency files in flight, whatever the batch size
+	std::atomic<size_t> next_job = 0;
+	for (unsigned worker = 0; worker < pool->GetThreadCount(); ++worker) {
+		pool->Submit([this, &jobs, &next_job, region, &cancelled]() {
+			for (size_t index; (index = next_job.fetch_add(1, std::memory_order_relaxed)) < jobs.size();) {
+				WriteJob(jobs[index], region, cancelled);
+			}
+		});
+	}
+	pool->WaitIdle();
+}
+
+void RegionConverter::WriteJob(Job& job, std::string_view region, const std::atomic<bool>& cancelled) {
+	if (cancelled.load(std::memory_order_relaxed)) {
+		job.status = PresetHeader::WriteStatus::FAILED;
+		job.error  = std::make_error_code(std::errc::operation_canceled);
+		return;
+	}
+
+	job.status = PresetHeader::WriteRegion(job.full_path, job.expected, region, job.written, job.error);
+	files_done.fetch_add(1, std::memory_order_relaxed);
+	if (job.status != PresetHeader::WriteStatus::WRITTEN)
+		return;
+
+	std::error_code canonical_error;
+	job.canonical_path = std::filesystem::weakly_canonical(job.full_path, canonical_error);
+	if (canonical_error) {
+		job.canonical_path = job.full_path;
+	}
+}
@@ -0,0 +1,75 @@
+#ifndef REGIONCONVERTER_H_
+#define REGIONCONVERTER_H_
+
+#include "FileInfo.h"
+#include "PresetHeader.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+/* Write stage of a region conversion. The caller plans the batch from the store and records the results back into it;
+ * in between, headers are patched and written on a pool with at most io_concurrency files in flight, so a large batch
+ * is bound by the disk rather than by one thread. A file that fails is reported on its job, the rest of the batch goes on. */
+class RegionConverter {
+public:
+	struct Job {
+		std::filesystem::path     relative_path; // Key in the store, looked up again when recording since the store may change meanwhile
+		std::filesystem::path     full_path;
+		FileInfo                  expected; // The file as loaded, the write is refused if it changed since
+
+		PresetHeader::WriteStatus status = PresetHeader::WriteStatus::FAILED;
+		FileInfo                  written;
+		std::filesystem::path     canonical_path; // Resolved on the worker, for recognizing our own write when the monitor reports it
+		std::error_code           error;
+	};
+
+	struct Statistics {
+		size_t                    planned   = 0;
+		size_t                    written   = 0;
+		size_t                    changed   = 0; // Refused, the file changed after it was loaded
+		size_t                    failed    = 0;
+		size_t                    cancelled = 0;
+		std::chrono::microseconds plan_time {};
+		std::chrono::microseconds write_time {};
+		std::chrono::microseconds record_time {};
+
+		[[nodiscard]] double      FilesPerSecond(std::chrono::microseconds stage_time) const; // Written files only, failed and cancelled ones are not throughput
+	};
+
+	struct Progress {
+		size_t done             = 0;
+		size_t total            = 0;
+		double files_per_second = 0.0;
+	};
+
+	explicit RegionConverter(unsigned io_concurrency = 0); // 0 picks from the hardware
+
+	// Blocks until every job has a status. Once cancelled is set, the jobs not yet started fail with operation_canceled.
+	void                   Write(std::vector<Job>& jobs, std::string_view region, const std::atomic<bool>& cancelled);
+	void                   SetConcurrency(unsigned io_concurrency); // Any thread, read once at the start of each batch
+	[[nodiscard]] unsigned GetConcurrency() const;
+	[[nodiscard]] Progress GetProgress() const; // Of the batch being written, or the last one. Safe from any thread.
+
+private:
+	using Clock                              = std::chrono::steady_clock;
+	static constexpr size_t     INLINE_BATCH = 8; // Smaller batches are written on the calling thread
+
+	std::atomic<unsigned>       io_concurrency;
+	std::unique_ptr<ThreadPool> pool; // Started by the first batch that needs it, restarted when the concurrency changed
+
+	std::atomic<size_t>         files_done  = 0;
+	std::atomic<size_t>         files_total = 0;
+	std::atomic<Clock::rep>     write_start = 0;
+	std::atomic<Clock::rep>     write_end   = 0; // 0 while a batch is being written
+
+	void                        WriteAll(std::vector<Job>& jobs, std::string_view region, const std::atomic<bool>& cancelled);
+	void                        WriteJob(Job& job, std::string_view region, const std::atomic<bool>& cancelled);
+};
+
+#endif /*! REGIONCONVERTER_H_ */
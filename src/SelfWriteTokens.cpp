@@ -0,0 +1,43 @@
+#include "SelfWriteTokens.h"
+
+#include "Debug.h"
+
+SelfWriteTokens::SelfWriteTokens(std::chrono::milliseconds lifetime)
+    : lifetime(lifetime) {
+}
+
+void SelfWriteTokens::Expect(const std::filesystem::path& canonical_path, const FileInfo& written) {
+	std::lock_guard<std::mutex> lock(mutex);
+	tokens.insert_or_assign(canonical_path, Token { written, next_generation++, Clock::now() + lifetime });
+}
+
+uint64_t SelfWriteTokens::Match(const std::filesystem::path& canonical_path, const FileInfo& current) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto                  it = tokens.find(canonical_path);
+	if (it == tokens.end())
+		return 0;
+
+	return it->second.written.HasSameMetadata(current) ? it->second.generation : 0;
+}
+
+void SelfWriteTokens::ExpireOld() {
+	std::lock_guard<std::mutex> lock(mutex);
+	const Clock::time_point     now     = Clock::now();
+	const size_t                expired = std::erase_if(tokens, [now](const auto& entry) {
+		return entry.second.expires <= now;
+	});
+
+	if (expired > 0) {
+		DEBUG_LOG("Expired " << expired << " self-write tokens, " << tokens.size() << " left.");
+	}
+}
+
+size_t SelfWriteTokens::Size() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return tokens.size();
+}
+
+void SelfWriteTokens::Clear() {
+	std::lock_guard<std::mutex> lock(mutex);
+	tokens.clear();
+}
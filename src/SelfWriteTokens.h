@@ -0,0 +1,45 @@
+#ifndef SELFWRITETOKENS_H_
+#define SELFWRITETOKENS_H_
+
+#include "FileInfo.h"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+
+/* Writes we made ourselves, each remembered as the exact (file_id, size, mtime) it left behind. A reported change is ours
+ * only while the file still matches its token, so an edit landing after our write is never mistaken for it, however many
+ * events the watcher sends for one write. Tokens are not consumed by a match, they expire after their lifetime.
+ * Conversion patches the header in place without reading the rest, so the content hash is never known here and is no
+ * part of a token. */
+class SelfWriteTokens {
+public:
+	explicit SelfWriteTokens(std::chrono::milliseconds lifetime);
+
+	// Replaces any token for the path, the newest write is the only one the file can still match
+	void                   Expect(const std::filesystem::path& canonical_path, const FileInfo& written);
+	// Generation of the token the file still matches, 0 when the change is not ours
+	[[nodiscard]] uint64_t Match(const std::filesystem::path& canonical_path, const FileInfo& current) const;
+	void                   ExpireOld();
+
+	[[nodiscard]] size_t   Size() const;
+	void                   Clear();
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Token {
+		FileInfo          written;    // Only file_id, size and mtime are compared
+		uint64_t          generation; // Order of the write, tells a token from the one it replaced
+		Clock::time_point expires;
+	};
+
+	std::chrono::milliseconds                        lifetime;
+	mutable std::mutex                               mutex;
+	std::unordered_map<std::filesystem::path, Token> tokens;
+	uint64_t                                         next_generation = 1;
+};
+
+#endif /*! SELFWRITETOKENS_H_ */
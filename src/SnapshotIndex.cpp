@@ -0,0 +1,225 @@
+#include "SnapshotIndex.h"
+
+#include "Debug.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+	constexpr char     INDEX_MAGIC[4] = { 'P', 'W', 'S', 'I' };
+	constexpr uint32_t INDEX_VERSION  = 1;
+
+	/* Layout (host byte order, the index never leaves the machine that wrote it):
+	 *   header: magic[4] u32 version  i64 saved_time  u64 entry_count  u32 root_length  root[root_length]
+	 *   entry:  u64 file_id  u64 size  i64 last_modified  u64 content_hash  char region[3]  u8 reserved  u32 path_length  path[path_length]
+	 * Paths are UTF-8, generic separators, relative to the root. */
+	constexpr size_t   ENTRY_FIXED_SIZE = 8 + 8 + 8 + 8 + 3 + 1 + 4;
+
+	class Reader {
+	public:
+		Reader(const char* data, size_t size)
+		    : cursor(data), end(data + size) {
+		}
+
+		template <typename T>
+		bool Read(T& value) {
+			if (static_cast<size_t>(end - cursor) < sizeof(T))
+				return false;
+			std::memcpy(&value, cursor, sizeof(T));
+			cursor += sizeof(T);
+			return true;
+		}
+
+		bool ReadBytes(void* destination, size_t length) {
+			if (static_cast<size_t>(end - cursor) < length)
+				return false;
+			std::memcpy(destination, cursor, length);
+			cursor += length;
+			return true;
+		}
+
+		bool ReadView(std::string_view& view, size_t length) {
+			if (static_cast<size_t>(end - cursor) < length)
+				return false;
+			view    = std::string_view(cursor, length);
+			cursor += length;
+			return true;
+		}
+
+		[[nodiscard]] size_t Remaining() const {
+			return static_cast<size_t>(end - cursor);
+		}
+
+	private:
+		const char* cursor;
+		const char* end;
+	};
+
+	template <typename T>
+	void Append(std::string& buffer, const T& value) {
+		buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+} // namespace
+
+SnapshotIndex::SnapshotIndex(std::filesystem::path index_path)
+    : index_path(std::move(index_path)) {
+}
+
+bool SnapshotIndex::Load(const std::filesystem::path& root_path) {
+	Release();
+
+	mapping = MappedFile(index_path);
+	if (!mapping.IsValid()) {
+		return false;
+	}
+
+	Reader           reader(mapping.data(), mapping.size());
+	char             magic[4];
+	uint32_t         version     = 0;
+	int64_t          saved_ticks = 0;
+	uint64_t         entry_count = 0;
+	uint32_t         root_length = 0;
+	std::string_view root;
+
+	if (!reader.ReadBytes(magic, sizeof(magic)) || std::memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0 ||
+	    !reader.Read(version) || version != INDEX_VERSION ||
+	    !reader.Read(saved_ticks) || !reader.Read(entry_count) ||
+	    !reader.Read(root_length) || !reader.ReadView(root, root_length)) {
+		DEBUG_LOG("Ignoring unreadable snapshot index: " << index_path);
+		Release();
+		return false;
+	}
+
+	if (root != MakeKey(root_path)) {
+		DEBUG_LOG("Snapshot index belongs to another directory, ignoring it.");
+		Release();
+		return false;
+	}
+
+	if (entry_count > reader.Remaining() / ENTRY_FIXED_SIZE) {
+		DEBUG_LOG("Snapshot index is truncated: " << index_path);
+		Release();
+		return false;
+	}
+
+	entries.reserve(entry_count);
+	for (uint64_t i = 0; i < entry_count; ++i) {
+		Entry            entry;
+		uint8_t          reserved    = 0;
+		uint32_t         path_length = 0;
+		std::string_view path;
+
+		if (!reader.Read(entry.file_id) || !reader.Read(entry.size) || !reader.Read(entry.last_modified) ||
+		    !reader.Read(entry.content_hash) || !reader.ReadBytes(entry.region, sizeof(entry.region)) ||
+		    !reader.Read(reserved) || !reader.Read(path_length) || !reader.ReadView(path, path_length)) {
+			DEBUG_LOG("Snapshot index is truncated: " << index_path);
+			Release();
+			return false;
+		}
+
+		entries.emplace(path, entry);
+	}
+
+	saved_time = std::chrono::time_point<std::chrono::file_clock>(std::chrono::file_clock::duration(saved_ticks));
+	DEBUG_LOG("Loaded snapshot index with " << entries.size() << " entries.");
+	return true;
+}
+
+bool SnapshotIndex::Save(const std::filesystem::path& root_path, const std::vector<std::pair<std::string, Entry>>& new_entries) const {
+	const std::string root        = MakeKey(root_path);
+	const int64_t     saved_ticks = std::chrono::file_clock::now().time_since_epoch().count();
+
+	std::string       buffer;
+	buffer.reserve(64 + root.size() + new_entries.size() * (ENTRY_FIXED_SIZE + 64));
+	buffer.append(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	Append(buffer, INDEX_VERSION);
+	Append(buffer, saved_ticks);
+	Append(buffer, static_cast<uint64_t>(new_entries.size()));
+	Append(buffer, static_cast<uint32_t>(root.size()));
+	buffer.append(root);
+
+	for (const auto& [key, entry] : new_entries) {
+		Append(buffer, entry.file_id);
+		Append(buffer, entry.size);
+		Append(buffer, entry.last_modified);
+		Append(buffer, entry.content_hash);
+		buffer.append(entry.region, sizeof(entry.region));
+		Append(buffer, uint8_t { 0 });
+		Append(buffer, static_cast<uint32_t>(key.size()));
+		buffer.append(key);
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(index_path.parent_path(), error);
+
+	// Write beside the live index and swap it in, a crash mid-write must not leave a torn index behind
+	std::filesystem::path temporary_path = index_path;
+	temporary_path += ".tmp";
+	{
+		std::ofstream f(temporary_path, std::ios::binary | std::ios::trunc);
+		if (!f.is_open()) {
+			DEBUG_LOG("Could not write snapshot index: " << temporary_path);
+			return false;
+		}
+		f.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		if (!f.good()) {
+			DEBUG_LOG("Could not write snapshot index: " << temporary_path);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(temporary_path, index_path, error);
+	if (error) {
+		DEBUG_LOG("Could not replace snapshot index: " << error.message());
+		return false;
+	}
+
+	DEBUG_LOG("Saved snapshot index with " << new_entries.size() << " entries.");
+	return true;
+}
+
+void SnapshotIndex::Release() {
+	entries.clear();
+	mapping = MappedFile();
+}
+
+bool SnapshotIndex::IsLoaded() const {
+	return mapping.IsValid();
+}
+
+const SnapshotIndex::Entry* SnapshotIndex::Find(std::string_view key) const {
+	auto it = entries.find(key);
+	return it != entries.end() ? &it->second : nullptr;
+}
+
+const std::unordered_map<std::string_view, SnapshotIndex::Entry>& SnapshotIndex::GetEntries() const {
+	return entries;
+}
+
+std::chrono::time_point<std::chrono::file_clock> SnapshotIndex::GetSavedTime() const {
+	return saved_time;
+}
+
+bool SnapshotIndex::IsUnchanged(const Entry& entry, const FileInfo& info) const {
+	return info.file_id != 0 &&
+	       entry.file_id == info.file_id &&
+	       entry.size == info.size &&
+	       entry.last_modified == info.last_modified.time_since_epoch().count() &&
+	       info.last_modified < saved_time - FileInfo::TIMESTAMP_GRANULARITY;
+}
+
+std::string SnapshotIndex::MakeKey(const std::filesystem::path& path_relative_to_root) {
+	const std::u8string key = path_relative_to_root.generic_u8string();
+	return std::string(key.begin(), key.end());
+}
+
+SnapshotIndex::Entry SnapshotIndex::MakeEntry(const FileInfo& info, std::string_view region) {
+	Entry entry;
+	entry.file_id       = info.file_id;
+	entry.size          = info.size;
+	entry.last_modified = info.last_modified.time_since_epoch().count();
+	entry.content_hash  = info.content_hash;
+	std::memcpy(entry.region, region.data(), std::min(region.size(), sizeof(entry.region)));
+	return entry;
+}
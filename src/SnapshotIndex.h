@@ -0,0 +1,52 @@
+#ifndef SNAPSHOTINDEX_H_
+#define SNAPSHOTINDEX_H_
+
+#include "FileInfo.h"
+#include "MappedFile.h"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/* Compact binary record of every preset seen on the last run: identity, metadata, XXH3 hash and decoded region.
+ * Loading maps the file and indexes it in place, so startup only has to stat each preset to know whether it changed. */
+class SnapshotIndex {
+public:
+	struct Entry {
+		uint64_t file_id       = 0;
+		uint64_t size          = 0;
+		int64_t  last_modified = 0; // file_clock ticks
+		uint64_t content_hash  = 0; // 0 when it was never hashed
+		char     region[3]     = {};
+	};
+
+	explicit SnapshotIndex(std::filesystem::path index_path);
+
+	bool                                                     Load(const std::filesystem::path& root_path);
+	bool                                                     Save(const std::filesystem::path& root_path, const std::vector<std::pair<std::string, Entry>>& entries) const;
+	void                                                     Release();
+
+	[[nodiscard]] bool                                       IsLoaded() const;
+	[[nodiscard]] const Entry*                               Find(std::string_view key) const;
+	[[nodiscard]] const std::unordered_map<std::string_view, Entry>& GetEntries() const;
+	[[nodiscard]] std::chrono::time_point<std::chrono::file_clock> GetSavedTime() const;
+
+	// An entry can be trusted when identity and metadata match and it was not written within the timestamp granularity of the save
+	[[nodiscard]] bool                                       IsUnchanged(const Entry& entry, const FileInfo& info) const;
+
+	static std::string                                       MakeKey(const std::filesystem::path& path_relative_to_root);
+	static Entry                                             MakeEntry(const FileInfo& info, std::string_view region);
+
+private:
+	std::filesystem::path                                    index_path;
+	MappedFile                                               mapping;
+	std::unordered_map<std::string_view, Entry>              entries;
+	std::chrono::time_point<std::chrono::file_clock>         saved_time;
+};
+
+#endif /*! SNAPSHOTINDEX_H_ */
@@ -0,0 +1,138 @@
+#include "ThreadPool.h"
+
+#include "Debug.h"
+
+#include <algorithm>
+
+namespace {
+	thread_local const ThreadPool* current_pool         = nullptr;
+	thread_local int               current_worker_index = -1;
+} // namespace
+
+ThreadPool::ThreadPool(unsigned thread_count) {
+	thread_count = std::max(1u, thread_count);
+
+	queues.reserve(thread_count);
+	for (unsigned i = 0; i < thread_count; ++i) {
+		queues.push_back(std::make_unique<WorkerQueue>());
+	}
+
+	workers.reserve(thread_count);
+	for (unsigned i = 0; i < thread_count; ++i) {
+		workers.emplace_back([this, i]() {
+			WorkerLoop(i);
+		});
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		stopping = true;
+	}
+	sleep_condition_variable.notify_all();
+
+	for (auto& worker : workers) {
+		if (worker.joinable()) {
+			worker.join();
+		}
+	}
+}
+
+unsigned ThreadPool::ResolveThreadCount(unsigned requested) {
+	if (requested != 0)
+		return requested;
+
+	return std::clamp(std::thread::hardware_concurrency(), 1u, 8u);
+}
+
+unsigned ThreadPool::GetThreadCount() const {
+	return static_cast<unsigned>(workers.size());
+}
+
+int ThreadPool::CurrentWorkerIndex() const {
+	return current_pool == this ? current_worker_index : -1;
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+	pending_tasks.fetch_add(1);
+	queued_tasks.fetch_add(1); // Before the push, so a worker taking it straight away never drives the count below zero
+
+	// Workers keep what they spawn, outside callers spread tasks round-robin
+	const int    worker_index = CurrentWorkerIndex();
+	const size_t queue_index  = worker_index >= 0 ? static_cast<size_t>(worker_index) : next_queue.fetch_add(1) % queues.size();
+	{
+		std::lock_guard<std::mutex> lock(queues[queue_index]->mutex);
+		queues[queue_index]->tasks.push_back(std::move(task));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex); // Pairs with the predicate check in WorkerLoop so the wakeup cannot be lost
+	}
+	sleep_condition_variable.notify_one();
+}
+
+void ThreadPool::WaitIdle() {
+	std::unique_lock<std::mutex> lock(idle_mutex);
+	idle_condition_variable.wait(lock, [this]() {
+		return pending_tasks.load() == 0;
+	});
+}
+
+bool ThreadPool::TryTake(unsigned index, std::function<void()>& task) {
+	{
+		WorkerQueue&                own = *queues[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty()) {
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+
+	for (size_t offset = 1; offset < queues.size(); ++offset) {
+		WorkerQueue&                victim = *queues[(index + offset) % queues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty()) {
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ThreadPool::WorkerLoop(unsigned index) {
+	current_pool         = this;
+	current_worker_index = static_cast<int>(index);
+
+	while (true) {
+		std::function<void()> task;
+		if (TryTake(index, task)) {
+			queued_tasks.fetch_sub(1);
+
+			try {
+				task();
+			} catch (const std::exception& e) {
+				DEBUG_LOG("ThreadPool task failed: " << e.what());
+			} catch (...) {
+				DEBUG_LOG("ThreadPool task failed.");
+			}
+
+			if (pending_tasks.fetch_sub(1) == 1) {
+				std::lock_guard<std::mutex> lock(idle_mutex);
+				idle_condition_variable.notify_all();
+			}
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		sleep_condition_variable.wait(lock, [this]() {
+			return stopping || queued_tasks.load() > 0;
+		});
+
+		if (stopping && queued_tasks.load() == 0)
+			return;
+	}
+}
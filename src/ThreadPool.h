@@ -0,0 +1,54 @@
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Fixed set of workers, each with its own task deque. A worker pops its newest task first and steals the oldest task
+ * from another worker when it runs dry, so recursive fan-out (a directory submitting its subdirectories) stays local. */
+class ThreadPool {
+public:
+	explicit ThreadPool(unsigned thread_count);
+	~ThreadPool();
+	ThreadPool(const ThreadPool& other)                     = delete;
+	ThreadPool&     operator=(const ThreadPool& other)      = delete;
+
+	void            Submit(std::function<void()> task);
+	void            WaitIdle(); // Blocks until every submitted task, including ones submitted by tasks, has finished
+	unsigned        GetThreadCount() const;
+
+	// Index of the calling worker in this pool, or -1 when called from any other thread
+	int             CurrentWorkerIndex() const;
+
+	static unsigned ResolveThreadCount(unsigned requested);
+
+private:
+	struct WorkerQueue {
+		std::mutex                        mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+	std::vector<std::thread>                  workers;
+
+	std::atomic<size_t>                       queued_tasks  = 0;
+	std::atomic<size_t>                       pending_tasks = 0;
+	std::atomic<size_t>                       next_queue    = 0;
+	bool                                      stopping      = false;
+
+	std::mutex                                sleep_mutex;
+	std::condition_variable                   sleep_condition_variable;
+	std::mutex                                idle_mutex;
+	std::condition_variable                   idle_condition_variable;
+
+	void                                      WorkerLoop(unsigned index);
+	bool                                      TryTake(unsigned index, std::function<void()>& task);
+};
+
+#endif /*! THREADPOOL_H_ */
@@ -0,0 +1,98 @@
+#include "UiUpdateQueue.h"
+
+#include "Debug.h"
+
+#include <algorithm>
+#include <app-window.h>
+#include <utility>
+
+UiUpdateQueue::UiUpdateQueue(Apply apply, std::chrono::milliseconds frame_interval)
+    : apply(std::move(apply)),
+      frame_interval(frame_interval),
+      rate_window_start(Clock::now()) {
+}
+
+UiUpdateQueue::~UiUpdateQueue() {
+	Node* node = head.exchange(nullptr);
+	while (node) {
+		delete std::exchange(node, node->next);
+	}
+}
+
+void UiUpdateQueue::Push(Update update) {
+	// Counted before it can be drained, so the depth never goes below zero
+	pushed.fetch_add(1, std::memory_order_relaxed);
+	const size_t depth = queue_depth.fetch_add(1, std::memory_order_relaxed) + 1;
+	size_t       peak  = peak_queue_depth.load(std::memory_order_relaxed);
+	while (depth > peak && !peak_queue_depth.compare_exchange_weak(peak, depth, std::memory_order_relaxed)) {
+	}
+
+	Node* node = new Node { std::move(update) };
+	node->next = head.load(std::memory_order_relaxed);
+	while (!head.compare_exchange_weak(node->next, node)) {
+	}
+
+	// Linked before the flag is taken: a drain that already cleared the flag either picks this node up or a new one is posted
+	if (!drain_scheduled.exchange(true)) {
+		posted.fetch_add(1, std::memory_order_relaxed);
+		slint::invoke_from_event_loop([this]() {
+			Drain();
+		});
+	}
+}
+
+UiUpdateQueue::Statistics UiUpdateQueue::GetStatistics() const {
+	return Statistics {
+		.queue_depth          = queue_depth.load(std::memory_order_relaxed),
+		.peak_queue_depth     = peak_queue_depth.load(std::memory_order_relaxed),
+		.pushed               = pushed.load(std::memory_order_relaxed),
+		.posted               = posted.load(std::memory_order_relaxed),
+		.drains               = drains.load(std::memory_order_relaxed),
+		.refreshes_per_second = refreshes_per_second.load(std::memory_order_relaxed),
+	};
+}
+
+void UiUpdateQueue::Drain() {
+	// Updates pushed while waiting for the frame join this drain, the flag stays taken so nothing else is posted
+	const Clock::duration since_last = Clock::now() - last_drain;
+	if (since_last < frame_interval) {
+		slint::Timer::single_shot(std::chrono::duration_cast<std::chrono::milliseconds>(frame_interval - since_last) + std::chrono::milliseconds(1), [this]() {
+			DrainNow();
+		});
+		return;
+	}
+
+	DrainNow();
+}
+
+void UiUpdateQueue::DrainNow() {
+	// Cleared before taking the list, a push after this posts the next drain
+	drain_scheduled.store(false);
+	Node* node = head.exchange(nullptr);
+	if (!node)
+		return; // Taken by the previous drain
+
+	std::vector<Update> updates;
+	while (node) {
+		updates.push_back(std::move(node->update));
+		delete std::exchange(node, node->next);
+	}
+	std::reverse(updates.begin(), updates.end());
+	queue_depth.fetch_sub(updates.size(), std::memory_order_relaxed);
+
+	last_drain = Clock::now();
+	drains.fetch_add(1, std::memory_order_relaxed);
+	if (last_drain - rate_window_start >= std::chrono::seconds(1)) {
+		const double seconds = std::chrono::duration<double>(last_drain - rate_window_start).count();
+		refreshes_per_second.store(rate_window_drains / seconds, std::memory_order_relaxed);
+		if (rate_window_drains > 1) {
+			const Statistics statistics = GetStatistics();
+			DEBUG_LOG("UI updates: " << statistics.refreshes_per_second << " refreshes/s, " << statistics.pushed << " pushed in " << statistics.posted << " posts, peak queue depth " << statistics.peak_queue_depth << ".");
+		}
+		rate_window_start  = last_drain;
+		rate_window_drains = 0;
+	}
+	rate_window_drains++;
+
+	apply(updates);
+}
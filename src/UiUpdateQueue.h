@@ -0,0 +1,71 @@
+#ifndef UIUPDATEQUEUE_H_
+#define UIUPDATEQUEUE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/* Carries updates from background threads to the UI thread. Pushing never blocks and never waits on the UI: updates go
+ * onto a lock-free list, and however many arrive only one drain is queued on the event loop at a time. The drain runs at
+ * most once per frame and hands over everything pushed until then, so a burst of updates costs one refresh. */
+class UiUpdateQueue {
+public:
+	struct Update {
+		size_t                changes = 0;     // Files the update touched, only counted
+		bool                  convert = false; // The presets on disk changed, worth an automatic conversion
+		std::function<void()> on_applied;      // Runs on the UI thread once the update is applied
+	};
+
+	struct Statistics {
+		size_t   queue_depth          = 0; // Pushed and not yet drained
+		size_t   peak_queue_depth     = 0;
+		uint64_t pushed               = 0;
+		uint64_t posted               = 0; // Drains queued on the event loop, pushed less posted is what coalescing saved
+		uint64_t drains               = 0;
+		double   refreshes_per_second = 0; // Drains per second over the last window of at least a second
+	};
+
+	// Called on the UI thread with the updates in the order they were pushed, never with none
+	using Apply = std::function<void(std::vector<Update>& updates)>;
+
+	UiUpdateQueue(Apply apply, std::chrono::milliseconds frame_interval);
+	~UiUpdateQueue();
+	UiUpdateQueue(const UiUpdateQueue& other)            = delete;
+	UiUpdateQueue& operator=(const UiUpdateQueue& other) = delete;
+
+	void                     Push(Update update); // Any thread
+	[[nodiscard]] Statistics GetStatistics() const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Node {
+		Update update;
+		Node*  next = nullptr;
+	};
+
+	Apply                     apply;
+	std::chrono::milliseconds frame_interval;
+
+	std::atomic<Node*>        head            = nullptr; // Newest first
+	std::atomic<bool>         drain_scheduled = false;
+
+	std::atomic<size_t>       queue_depth          = 0;
+	std::atomic<size_t>       peak_queue_depth     = 0;
+	std::atomic<uint64_t>     pushed               = 0;
+	std::atomic<uint64_t>     posted               = 0;
+	std::atomic<uint64_t>     drains               = 0;
+	std::atomic<double>       refreshes_per_second = 0;
+
+	// UI thread only
+	Clock::time_point         last_drain;
+	Clock::time_point         rate_window_start;
+	uint64_t                  rate_window_drains = 0;
+
+	void                      Drain(); // UI thread, holds off until a frame has passed since the last one
+	void                      DrainNow();
+};
+
+#endif /*! UIUPDATEQUEUE_H_ */
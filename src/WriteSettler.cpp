@@ -0,0 +1,155 @@
+#include "WriteSettler.h"
+
+#include <algorithm>
+
+using ChangeInfo = DirectoryMonitor::ChangeInfo;
+
+WriteSettler::WriteSettler(std::chrono::milliseconds settle_period, std::chrono::milliseconds tick)
+    : settle_period(settle_period), tick(std::max(tick, std::chrono::milliseconds(1))), wheel_time(Clock::now()) {
+	// The wheel may lag the clock by up to a tick, timers are armed one tick further out so none fires before a full period
+	const auto period_ticks = static_cast<size_t>((settle_period + this->tick - std::chrono::milliseconds(1)) / this->tick);
+	wheel.resize(period_ticks + 2);
+}
+
+void WriteSettler::Settle(std::vector<ChangeInfo>& changes) {
+	if (settle_period.count() <= 0) {
+		return;
+	}
+
+	std::vector<ChangeInfo> released;
+	Advance(released);
+
+	for (const auto& change : changes) {
+		Hold(change, released);
+	}
+
+	changes = std::move(released);
+}
+
+size_t WriteSettler::GetPendingCount() const {
+	return pending_changes.size();
+}
+
+void WriteSettler::Clear() {
+	pending_changes.clear();
+	for (auto& slot : wheel) {
+		slot.clear();
+	}
+}
+
+void WriteSettler::Hold(const ChangeInfo& change, std::vector<ChangeInfo>& released) {
+	switch (change.type) {
+		case ChangeInfo::ADDED:
+		case ChangeInfo::MODIFIED: {
+			if (const auto found = pending_changes.find(change.path); found != pending_changes.end()) {
+				// Already armed. The recheck at its deadline sees this write, an addition stays an addition.
+				if (change.type == ChangeInfo::ADDED) {
+					found->second.type = ChangeInfo::ADDED;
+				}
+				found->second.contents = change.contents;
+				return;
+			}
+
+			std::error_code error;
+			FileInfo        info = FileInfo::ReadMetadata(change.path, error);
+			if (error) {
+				return; // Gone again, the backend reports the deletion
+			}
+
+			auto [inserted, _] = pending_changes.emplace(change.path, PendingChange { change.type, info, 0, change.contents });
+			Arm(inserted->first, inserted->second);
+			return;
+		}
+		case ChangeInfo::DELETED: {
+			if (const auto found = pending_changes.find(change.path); found != pending_changes.end()) {
+				const bool never_reported = found->second.type == ChangeInfo::ADDED;
+				pending_changes.erase(found);
+				if (never_reported) {
+					return;
+				}
+			}
+			break;
+		}
+		case ChangeInfo::RENAMED: {
+			pending_changes.erase(change.path); // Replaced by the renamed file
+
+			if (const auto found = pending_changes.find(change.old_path); found != pending_changes.end()) {
+				PendingChange moved = found->second;
+				pending_changes.erase(found);
+
+				auto [inserted, _] = pending_changes.emplace(change.path, moved);
+				Arm(inserted->first, inserted->second);
+
+				if (moved.type == ChangeInfo::ADDED) {
+					return; // The old path was never reported, the new one will be once it settles
+				}
+			}
+			break;
+		}
+	}
+
+	released.push_back(change);
+}
+
+void WriteSettler::Arm(const std::filesystem::path& path, PendingChange& pending) {
+	const size_t slot = (current_slot + wheel.size() - 1) % wheel.size();
+	pending.timer_id  = ++next_timer_id;
+	wheel[slot].push_back(Timer { path, pending.timer_id });
+}
+
+void WriteSettler::Advance(std::vector<ChangeInfo>& released) {
+	const auto now     = Clock::now();
+	const auto elapsed = static_cast<size_t>((now - wheel_time) / tick);
+	if (elapsed == 0) {
+		return;
+	}
+
+	wheel_time += elapsed * tick;
+
+	// Collect before expiring, so timers re-armed below are measured from the slot the wheel ends up on
+	due_timers.clear();
+	for (size_t step = 0; step < std::min(elapsed, wheel.size()); ++step) {
+		current_slot = (current_slot + 1) % wheel.size();
+		auto& slot   = wheel[current_slot];
+		std::move(slot.begin(), slot.end(), std::back_inserter(due_timers));
+		slot.clear();
+	}
+
+	if (elapsed > wheel.size()) {
+		current_slot = (current_slot + elapsed - wheel.size()) % wheel.size();
+	}
+
+	for (const Timer& timer : due_timers) {
+		Expire(timer, released);
+	}
+}
+
+void WriteSettler::Expire(const Timer& timer, std::vector<ChangeInfo>& released) {
+	const auto found = pending_changes.find(timer.path);
+	if (found == pending_changes.end() || found->second.timer_id != timer.timer_id) {
+		return;
+	}
+
+	PendingChange&  pending = found->second;
+	std::error_code error;
+	FileInfo        info = FileInfo::ReadMetadata(timer.path, error);
+	if (error) {
+		pending_changes.erase(found);
+		return;
+	}
+
+	if (info.HasSameMetadata(pending.info)) {
+		// Bytes read before the last write are dropped, the consumer reads the file itself
+		if (pending.contents && !pending.contents->info.HasSameMetadata(info)) {
+			pending.contents.reset();
+		}
+
+		released.push_back(ChangeInfo { pending.type, timer.path, {}, std::move(pending.contents) });
+		pending_changes.erase(found);
+		return;
+	}
+
+	// Still being written
+	pending.info = info;
+	Arm(found->first, pending);
+}
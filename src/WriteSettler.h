@@ -0,0 +1,56 @@
+#ifndef WRITESETTLER_H_
+#define WRITESETTLER_H_
+
+#include "DirectoryMonitor.h"
+#include "FileInfo.h"
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/* Holds back ADDED and MODIFIED changes until the file has stopped moving, so a preset caught mid-write is not loaded.
+ * A held path is stat'ed again once the quiet period has passed and released only if its (file_id, size, mtime) did not
+ * change in between, otherwise it waits another period. Deadlines sit in a timer wheel with one slot per tick, so each
+ * call only looks at the slots that came due, however many paths are held. Deletions and renames pass straight through. */
+class WriteSettler {
+public:
+	explicit WriteSettler(std::chrono::milliseconds settle_period, std::chrono::milliseconds tick = std::chrono::milliseconds(50));
+
+	// Replaces changes with what may be reported now: held paths that settled first, then this scan's deletions and renames
+	void                 Settle(std::vector<DirectoryMonitor::ChangeInfo>& changes);
+	[[nodiscard]] size_t GetPendingCount() const;
+	void                 Clear();
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct PendingChange {
+		DirectoryMonitor::ChangeInfo::Type                    type;
+		FileInfo                                              info;     // Metadata when the timer was armed
+		uint32_t                                              timer_id; // Timers carrying another id were superseded
+		std::shared_ptr<const DirectoryMonitor::FileContents> contents; // From the latest change, passed on if the file did not move since
+	};
+
+	struct Timer {
+		std::filesystem::path path;
+		uint32_t              timer_id;
+	};
+
+	std::chrono::milliseconds                                      settle_period;
+	std::chrono::milliseconds                                      tick;
+	std::unordered_map<std::filesystem::path, PendingChange>       pending_changes;
+	std::vector<std::vector<Timer>>                                wheel; // Sized so one period fits in less than a revolution
+	size_t                                                         current_slot = 0;
+	Clock::time_point                                              wheel_time;
+	uint32_t                                                       next_timer_id = 0;
+	std::vector<Timer>                                             due_timers; // Scratch for Advance, kept for its capacity
+
+	void                                                           Hold(const DirectoryMonitor::ChangeInfo& change, std::vector<DirectoryMonitor::ChangeInfo>& released);
+	void                                                           Arm(const std::filesystem::path& path, PendingChange& pending);
+	void                                                           Advance(std::vector<DirectoryMonitor::ChangeInfo>& released);
+	void                                                           Expire(const Timer& timer, std::vector<DirectoryMonitor::ChangeInfo>& released);
+};
+
+#endif /*! WRITESETTLER_H_ */
@@ -1,17 +1,15 @@
 #include "CusManager.h"
-#include "DirectoryMonitor.h"
 #include "OperatingSystemFunctions.h"
 
 #include <app-window.h>
 #include <windows.h>
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
-	auto                                    ui                = AppWindow::create();
+	auto                              ui               = AppWindow::create();
 
-	const std::unique_ptr<CusManager>       cus_file_manager  = std::make_unique<CusManager>(ui);
-	const std::unique_ptr<DirectoryMonitor> directory_monitor = std::make_unique<DirectoryMonitor>(cus_file_manager->GetCustomizingDirectory()); // TODO: Lives in cus file manager now, remove
+	const std::unique_ptr<CusManager> cus_file_manager = std::make_unique<CusManager>(ui);
 
-	auto                                    initial_region    = slint::SharedString(OperatingSystemFunctions::GetLocalizationRegion());
+	auto                              initial_region   = slint::SharedString(OperatingSystemFunctions::GetLocalizationRegion());
 	ui->global<GlobalVariables>().set_local_region(initial_region);
 	ui->global<GlobalVariables>().set_selected_region(initial_region);
 
@@ -19,14 +17,11 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 	cus_file_manager->RefreshUnconvertedFiles(initial_region.data());
 ;
 	ui->global<GlobalVariables>().on_selected_region_changed([&cus_file_manager](const slint::SharedString& selected_region) {
-		std::lock_guard<std::mutex> lock(cus_file_manager->conversion_mutex);
-
 		cus_file_manager->SetSelectedRegionSafe(selected_region.data());
 
+		// Supersedes a conversion still running for the previous region
 		if (cus_file_manager->GetAutomaticConversionEnabled()) {
-			if (cus_file_manager->ConvertFilesToRegion(cus_file_manager->GetSelectedRegionSafe())) {
-				cus_file_manager->RefreshUnconvertedFiles(cus_file_manager->GetSelectedRegionSafe());
-			}
+			cus_file_manager->RequestConversion(selected_region.data());
 		}
 	});
 
@@ -37,16 +32,16 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 
 	ui->global<GlobalVariables>().on_convert_files([&cus_file_manager, &ui]() -> void {
 		const auto region = ui->global<GlobalVariables>().get_selected_region();
-		if (!cus_file_manager->ConvertFilesToRegion(region.data())) {
-			return;
-		}
+		cus_file_manager->RequestConversion(region.data(), [&ui](const CusManager::ConversionResult& result) -> void {
+			// Only a clean, complete batch flashes, failures are listed under the buttons
+			if (result.outcome != ConversionService::Outcome::CONVERTED || !result.failures.empty())
+				return;
 
-		cus_file_manager->RefreshUnconvertedFiles(region.data());
+			ui->global<GlobalVariables>().set_convert_button_flashing(true);
 
-		ui->global<GlobalVariables>().set_convert_button_flashing(true);
-
-		slint::Timer::single_shot(std::chrono::milliseconds(500), [&ui]() -> void {
-			ui->global<GlobalVariables>().set_convert_button_flashing(false);
+			slint::Timer::single_shot(std::chrono::milliseconds(500), [&ui]() -> void {
+				ui->global<GlobalVariables>().set_convert_button_flashing(false);
+			});
 		});
 	});
 
@@ -55,9 +50,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 		ui->global<GlobalVariables>().set_automatically_converting(enabled);
 		cus_file_manager->SetAutomaticConversionEnabled(enabled);
 		const auto region = ui->global<GlobalVariables>().get_selected_region();
-		if (cus_file_manager->ConvertFilesToRegion(region.data())) {
-			cus_file_manager->RefreshUnconvertedFiles(region.data());
-		}
+		cus_file_manager->RequestConversion(region.data());
 	});
 
 	ui->run();
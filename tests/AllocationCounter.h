@@ -0,0 +1,42 @@
+#ifndef ALLOCATIONCOUNTER_H_
+#define ALLOCATIONCOUNTER_H_
+
+// Replaces the global operator new and delete to count allocations and the bytes they hold. Include from exactly one
+// file of a test executable.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace AllocationCounter {
+	inline std::atomic<size_t>   count      = 0;
+	inline std::atomic<size_t>   live_bytes = 0;
+
+	constexpr size_t             HEADER     = alignof(std::max_align_t); // Holds the size, keeps the block aligned
+} // namespace AllocationCounter
+
+void* operator new(size_t size) {
+	AllocationCounter::count.fetch_add(1, std::memory_order_relaxed);
+	AllocationCounter::live_bytes.fetch_add(size, std::memory_order_relaxed);
+	if (char* block = static_cast<char*>(std::malloc(size + AllocationCounter::HEADER))) {
+		*reinterpret_cast<size_t*>(block) = size;
+		return block + AllocationCounter::HEADER;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+	if (!memory)
+		return;
+
+	char* block = static_cast<char*>(memory) - AllocationCounter::HEADER;
+	AllocationCounter::live_bytes.fetch_sub(*reinterpret_cast<size_t*>(block), std::memory_order_relaxed);
+	std::free(block);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+	operator delete(memory);
+}
+
+#endif /*! ALLOCATIONCOUNTER_H_ */
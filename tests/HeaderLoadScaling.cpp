@@ -0,0 +1,106 @@
+// Cold-load header reads over a 20k-preset tree at 1, 2, 4 and 8 threads, with the pull pattern of
+// CusManager::LoadFilesFromDisk: each worker stats and reads the header of the next file off a shared counter into that
+// file's own slot. Reads come from the page cache after a warm-up pass. Scaling needs as many cores as threads, the
+// hardware's count is printed with the timings. Run by ctest, exits non-zero when a thread count reads different
+// regions or metadata than the single-threaded pass.
+
+#include "FileInfo.h"
+#include "PresetHeader.h"
+#include "ThreadPool.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	using Clock                                          = std::chrono::steady_clock;
+
+	constexpr int                        DIRECTORY_COUNT = 40;
+	constexpr int                        PRESETS_PER_DIR = 500;
+	constexpr std::array<unsigned, 4>    THREAD_COUNTS   = { 1, 2, 4, 8 };
+	constexpr std::array<const char*, 3> REGIONS         = { "USA", "KOR", "RUS" };
+
+	struct LoadedHeader {
+		FileInfo    info;
+		std::string region;
+	};
+
+	void LoadHeader(const fs::path& path, LoadedHeader& loaded) {
+		loaded.info = FileInfo::ReadMetadata(path);
+		PresetHeader::Bytes header;
+		if (loaded.info.size >= PresetHeader::SIZE && PresetHeader::Read(path, header)) {
+			loaded.region.assign(header.data() + PresetHeader::REGION_OFFSET, PresetHeader::REGION_LENGTH);
+		}
+	}
+
+	std::vector<LoadedHeader> LoadAll(const std::vector<fs::path>& paths, unsigned thread_count) {
+		std::vector<LoadedHeader> loaded(paths.size());
+		if (thread_count <= 1) {
+			for (size_t index = 0; index < paths.size(); ++index) {
+				LoadHeader(paths[index], loaded[index]);
+			}
+			return loaded;
+		}
+
+		ThreadPool          pool(thread_count);
+		std::atomic<size_t> next_file = 0;
+		for (unsigned worker = 0; worker < thread_count; ++worker) {
+			pool.Submit([&]() {
+				for (size_t index; (index = next_file.fetch_add(1, std::memory_order_relaxed)) < paths.size();) {
+					LoadHeader(paths[index], loaded[index]);
+				}
+			});
+		}
+		pool.WaitIdle();
+		return loaded;
+	}
+
+	bool SameResults(const std::vector<LoadedHeader>& left, const std::vector<LoadedHeader>& right) {
+		for (size_t index = 0; index < left.size(); ++index) {
+			if (left[index].region != right[index].region || !left[index].info.HasSameMetadata(right[index].info))
+				return false;
+		}
+		return left.size() == right.size();
+	}
+} // namespace
+
+int main() {
+	const fs::path root = fs::temp_directory_path() / "PresetWeaverHeaderLoadScaling";
+	fs::remove_all(root);
+
+	std::vector<fs::path> paths;
+	for (int directory = 0; directory < DIRECTORY_COUNT; ++directory) {
+		const fs::path directory_path = root / ("d" + std::to_string(directory));
+		fs::create_directories(directory_path);
+		for (int file = 0; file < PRESETS_PER_DIR; ++file) {
+			paths.push_back(directory_path / ("p" + std::to_string(file) + ".cus"));
+			std::string contents(PresetHeader::SIZE + 256, '\0');
+			contents.replace(PresetHeader::REGION_OFFSET, PresetHeader::REGION_LENGTH, REGIONS[paths.size() % REGIONS.size()]);
+			std::ofstream(paths.back(), std::ios::binary) << contents;
+		}
+	}
+
+	const std::vector<LoadedHeader> expected = LoadAll(paths, 1); // Also warms the page cache
+	bool                            passed   = true;
+
+	std::printf("%zu presets, %u hardware threads:\n", paths.size(), std::thread::hardware_concurrency());
+	double single_thread = 0;
+	for (unsigned thread_count : THREAD_COUNTS) {
+		const Clock::time_point         start   = Clock::now();
+		const std::vector<LoadedHeader> loaded  = LoadAll(paths, thread_count);
+		const double                    seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		const bool                      same    = SameResults(expected, loaded);
+		single_thread                           = thread_count == 1 ? seconds : single_thread;
+
+		std::printf("  %u threads  %7.1f ms  %6.2fx  %s\n", thread_count, seconds * 1000, single_thread / seconds, same ? "same results" : "DIFFERENT RESULTS");
+		passed = passed && same;
+	}
+
+	fs::remove_all(root);
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+// UI refresh cost at 1k, 10k and 50k presets, with one preset changed, one removed and one added per refresh: the
+// PresetListModel diff of the new snapshot against the one it shows, with a PresetRegionView per region as CusManager
+// registers them, against the full rebuild it replaced, which copied every row of the snapshot into a VectorModel. Slint
+// is not running, so the notifications reach no view and the timings are the models' own work. Run by ctest, exits
+// non-zero when a diffed model's rows differ from a model built fresh from the same snapshot.
+
+#include "PresetListModel.h"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+	using Clock                                        = std::chrono::steady_clock;
+
+	constexpr std::array<size_t, 3>      ROW_COUNTS    = { 1000, 10000, 50000 };
+	constexpr size_t                     REFRESH_COUNT = 100;
+	constexpr std::array<const char*, 3> REGIONS       = { "USA", "KOR", "RUS" };
+
+	fs::path PresetPath(size_t index) {
+		return fs::path("Region " + std::to_string(index % 500)) / ("Vehicle Setup " + std::to_string(index) + ".cus");
+	}
+
+	struct ShownModel {
+		std::shared_ptr<PresetListModel>               model;
+		std::vector<std::shared_ptr<PresetRegionView>> views;
+	};
+
+	// As CusManager builds its models: every region in one list, a view leaving out each region
+	ShownModel CreateModel() {
+		ShownModel shown { std::make_shared<PresetListModel>(std::vector<std::string>(REGIONS.begin(), REGIONS.end())), {} };
+		for (const char* region : REGIONS) {
+			shown.views.push_back(PresetRegionView::Create(shown.model, region));
+		}
+		return shown;
+	}
+
+	// As RefreshUnconvertedFiles filled its VectorModel before the models read the snapshot
+	std::shared_ptr<slint::VectorModel<SlintCusFile>> RebuildVectorModel(const CusFileSnapshot& snapshot) {
+		std::vector<SlintCusFile> rows;
+		for (const char* region : REGIONS) {
+			if (const CusFileSnapshot::Region* files = snapshot.FindRegion(region)) {
+				const slint::SharedString region_string(region);
+				files->ForEach([&](const CusFileSnapshot::File& file) {
+					rows.push_back({ slint::SharedString(file.relative_path.string()), region_string, static_cast<int>(file.info.size), file.invalid });
+				});
+			}
+		}
+		return std::make_shared<slint::VectorModel<SlintCusFile>>(std::move(rows));
+	}
+
+	bool SameRows(const PresetListModel& left, const PresetListModel& right) {
+		if (left.row_count() != right.row_count())
+			return false;
+
+		for (size_t row = 0; row < left.row_count(); ++row) {
+			const std::optional<SlintCusFile> left_row  = left.row_data(row);
+			const std::optional<SlintCusFile> right_row = right.row_data(row);
+			if (!left_row || !right_row || left_row->path != right_row->path || left_row->region != right_row->region || left_row->data_size != right_row->data_size)
+				return false;
+		}
+		return true;
+	}
+
+	double Milliseconds(Clock::duration duration) {
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+} // namespace
+
+int main() {
+	bool passed = true;
+	std::printf("%zu refreshes of one changed, one removed and one added preset:\n", REFRESH_COUNT);
+	std::printf("  %6s  %12s  %12s  %12s\n", "rows", "diff", "new model", "VectorModel");
+
+	for (size_t row_count : ROW_COUNTS) {
+		CusFileStore store;
+		for (size_t index = 0; index < row_count; ++index) {
+			store.SetRegion(store.Insert(PresetPath(index)).first, REGIONS[index % REGIONS.size()]);
+		}
+		store.Publish();
+
+		ShownModel shown = CreateModel();
+		shown.model->Update(store.GetSnapshot());
+
+		Clock::duration diff    = {};
+		Clock::duration model   = {};
+		Clock::duration vectors = {};
+		size_t          next    = row_count;
+		for (size_t refresh = 0; refresh < REFRESH_COUNT; ++refresh) {
+			// Spread over the list, so the diff does not always find the change in the same chunk
+			const size_t changed = (refresh * 7919) % next;
+			if (CusFile* file = store.Find(PresetPath(changed))) {
+				FileInfo info = file->info;
+				info.size    += 1;
+				store.SetInfo(file, info);
+			}
+			store.Erase(PresetPath((changed + row_count / 2) % next));
+			store.SetRegion(store.Insert(PresetPath(next++)).first, REGIONS[refresh % REGIONS.size()]);
+			store.Publish();
+
+			const std::shared_ptr<const CusFileSnapshot> snapshot = store.GetSnapshot();
+
+			Clock::time_point start = Clock::now();
+			shown.model->Update(snapshot);
+			diff += Clock::now() - start;
+
+			start = Clock::now();
+			ShownModel fresh = CreateModel();
+			fresh.model->Update(snapshot);
+			model += Clock::now() - start;
+
+			start = Clock::now();
+			const auto rebuilt = RebuildVectorModel(*snapshot);
+			vectors += Clock::now() - start;
+
+			if (refresh + 1 == REFRESH_COUNT) {
+				const bool same = SameRows(*shown.model, *fresh.model) && rebuilt->row_count() == shown.model->row_count();
+				passed          = passed && same;
+				if (!same) {
+					std::printf("  %6zu rows: diffed model DIFFERS from a fresh one\n", row_count);
+				}
+			}
+		}
+
+		std::printf("  %6zu  %9.3f ms  %9.3f ms  %9.3f ms\n", row_count, Milliseconds(diff) / REFRESH_COUNT, Milliseconds(model) / REFRESH_COUNT, Milliseconds(vectors) / REFRESH_COUNT);
+	}
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+// Memory per tracked file and lookup latency at 100k preset paths, for the polling backend's FlatPathMap records against
+// the unordered_map keyed by std::filesystem::path they replaced. Bytes are the live heap held once every path is
+// inserted, counted by a replaced global operator new. Run by ctest, exits non-zero when a lookup misses or the flat map
+// takes as much memory per file as the node map.
+
+#include "AllocationCounter.h"
+#include "FileInfo.h"
+#include "FlatPathMap.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+	using Clock                         = std::chrono::steady_clock;
+
+	constexpr size_t    FILE_COUNT      = 100000;
+	constexpr int       LOOKUP_PASSES   = 10;
+
+	// Same fields as PollingChangeSource's file records, before and after FlatPathMap
+	struct NodeMapRecord {
+		FileInfo        info;
+		const fs::path* path        = nullptr;
+		void*           directory   = nullptr;
+		NodeMapRecord*  moved_from  = nullptr;
+		uint32_t        generation  = 0;
+		bool            is_new_path = false;
+		bool            modified    = false;
+		bool            moved_away  = false;
+	};
+
+	struct FlatRecord : FlatPathMapNode {
+		FileInfo    info;
+		void*       directory   = nullptr;
+		FlatRecord* moved_from  = nullptr;
+		uint32_t    generation  = 0;
+		bool        is_new_path = false;
+		bool        modified    = false;
+		bool        moved_away  = false;
+		bool        unhashed    = false;
+	};
+
+	struct Measurement {
+		double bytes_per_file      = 0;
+		double nanoseconds_per_get = 0;
+		size_t found               = 0;
+	};
+
+	template <typename Insert, typename Find>
+	Measurement Measure(const std::vector<fs::path>& paths, const std::vector<size_t>& order, Insert&& insert, Find&& find) {
+		Measurement  measurement;
+		const size_t bytes_before       = AllocationCounter::live_bytes.load();
+		for (const fs::path& path : paths) {
+			insert(path);
+		}
+		measurement.bytes_per_file      = static_cast<double>(AllocationCounter::live_bytes.load() - bytes_before) / paths.size();
+
+		const Clock::time_point start   = Clock::now();
+		for (int pass = 0; pass < LOOKUP_PASSES; ++pass) {
+			for (size_t index : order) {
+				measurement.found += find(paths[index]) ? 1 : 0;
+			}
+		}
+		const double nanoseconds        = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+		measurement.nanoseconds_per_get = nanoseconds / (static_cast<double>(order.size()) * LOOKUP_PASSES);
+		measurement.found /= LOOKUP_PASSES;
+		return measurement;
+	}
+} // namespace
+
+int main() {
+	// Paths shaped like a preset library: a few hundred directories, a few hundred presets in each
+	std::vector<fs::path> paths;
+	paths.reserve(FILE_COUNT);
+	for (size_t file = 0; file < FILE_COUNT; ++file) {
+		paths.push_back(fs::path("/home/user/Documents/Presets") / ("Region " + std::to_string(file / 400)) / ("Vehicle Setup " + std::to_string(file % 400) + ".cus"));
+	}
+
+	std::vector<size_t> order(FILE_COUNT);
+	for (size_t index = 0; index < order.size(); ++index) {
+		order[index] = index;
+	}
+	std::shuffle(order.begin(), order.end(), std::mt19937(42));
+
+	Measurement node_map;
+	{
+		std::unordered_map<fs::path, NodeMapRecord> records;
+		node_map = Measure(
+		    paths, order,
+		    [&](const fs::path& path) {
+			    auto [iterator, inserted] = records.try_emplace(path);
+			    iterator->second.path     = &iterator->first;
+		    },
+		    [&](const fs::path& path) { return records.find(path) != records.end(); });
+	}
+
+	Measurement flat_map;
+	{
+		FlatPathMap<FlatRecord> records;
+		flat_map = Measure(
+		    paths, order, [&](const fs::path& path) { records.TryEmplace(path.native()); }, [&](const fs::path& path) { return records.Find(path.native()) != nullptr; });
+	}
+
+	std::printf("%zu files, lookups in random order:\n", FILE_COUNT);
+	std::printf("  unordered_map<path, record>  %6.0f bytes per file  %6.1f ns per lookup\n", node_map.bytes_per_file, node_map.nanoseconds_per_get);
+	std::printf("  FlatPathMap<record>          %6.0f bytes per file  %6.1f ns per lookup\n", flat_map.bytes_per_file, flat_map.nanoseconds_per_get);
+
+	return node_map.found == FILE_COUNT && flat_map.found == FILE_COUNT && flat_map.bytes_per_file < node_map.bytes_per_file ? 0 : 1;
+}
@@ -0,0 +1,51 @@
+// A polling tick over a tree where nothing changed must not allocate: one quiet tick over 10k presets, counted by a
+// replaced global operator new. Run by ctest, exits non-zero on failure.
+
+#include "AllocationCounter.h"
+#include "PollingChangeSource.h"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+	constexpr int DIRECTORY_COUNT     = 100;
+	constexpr int FILES_PER_DIRECTORY = 100;
+} // namespace
+
+int main() {
+	const fs::path root = fs::temp_directory_path() / "PresetWeaverQuietScan";
+	fs::remove_all(root);
+	for (int directory = 0; directory < DIRECTORY_COUNT; ++directory) {
+		const fs::path directory_path = root / ("d" + std::to_string(directory % 10)) / ("e" + std::to_string(directory));
+		fs::create_directories(directory_path);
+		for (int file = 0; file < FILES_PER_DIRECTORY; ++file) {
+			std::ofstream(directory_path / ("p" + std::to_string(file) + ".cus")) << "preset " << directory << " " << file;
+		}
+	}
+
+	// Past the racily-clean window, so the first scan's hashes and listings are trusted by the next one
+	std::this_thread::sleep_for(FileInfo::TIMESTAMP_GRANULARITY + std::chrono::milliseconds(100));
+
+	int result = 0;
+	{
+		// More than one thread, so there is a pool to avoid whatever the machine's core count
+		DirectoryScanOptions options;
+		options.thread_count = 4;
+		PollingChangeSource source(root, true, options);
+
+		const size_t before  = AllocationCounter::count.load();
+		const auto   changes = source.CollectChanges();
+		const size_t used    = AllocationCounter::count.load() - before;
+
+		std::cout << "Quiet tick over " << source.GetFileCount() << " files: " << changes.size() << " changes, " << used << " allocations, "
+		          << source.GetLastScanStatistics().hashes_computed << " hashed." << std::endl;
+		if (!changes.empty() || used != 0 || source.GetFileCount() != DIRECTORY_COUNT * FILES_PER_DIRECTORY) {
+			result = 1;
+		}
+	}
+
+	fs::remove_all(root);
+	return result;
+}
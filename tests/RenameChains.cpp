@@ -0,0 +1,164 @@
+// Rename chains applied to the file store: a swap through a temporary file (x->t, y->x, t->y), a rotation, and a file
+// written and renamed in the same tick, replayed through ChangeBatch and applied the way CusManager's monitor thread does.
+// On Linux the swap is also made on disk and replayed as the inotify backend reports it. Each file's region is its
+// contents, so an entry that moved wrongly shows up as a path holding another file's region. Run by ctest, exits
+// non-zero on failure.
+
+#include "ChangeBatch.h"
+#include "CusFileStore.h"
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+	using ChangeInfo = DirectoryMonitor::ChangeInfo;
+
+	std::string ReadContents(const fs::path& path) {
+		std::ifstream      file(path);
+		std::ostringstream contents;
+		contents << file.rdbuf();
+		return contents.str();
+	}
+
+	// As CusManager applies a batch: moves in order (RemoveFile, RenameFile), then loads
+	void Apply(CusFileStore& store, const fs::path& root, const std::vector<ChangeInfo>& changes) {
+		const ChangeBatch batch(changes);
+		for (const ChangeInfo& change : batch.GetMoves()) {
+			const fs::path old_path = fs::relative(change.type == ChangeInfo::DELETED ? change.path : change.old_path, root);
+			CusFile*       file     = store.Find(old_path);
+			if (change.type == ChangeInfo::DELETED || !file) {
+				store.Erase(old_path);
+				if (change.type == ChangeInfo::RENAMED) {
+					store.SetRegion(store.Insert(fs::relative(change.path, root)).first, ReadContents(change.path));
+				}
+				continue;
+			}
+
+			const fs::path new_path = fs::relative(change.path, root);
+			if (new_path != old_path) {
+				store.Erase(new_path);
+				store.Rename(file, new_path);
+			}
+		}
+
+		for (const auto& [canonical_path, load] : batch.GetLoads()) {
+			store.SetRegion(store.Insert(fs::relative(load.path, root)).first, ReadContents(load.path));
+		}
+		store.Publish();
+	}
+
+	void Write(const fs::path& path, const std::string& contents) {
+		std::ofstream(path) << contents;
+	}
+
+	// Every file on disk is in the store with its own contents as region, and nothing else is
+	bool Check(const char* scenario, const CusFileStore& store, const fs::path& root) {
+		std::map<std::string, std::string> expected;
+		for (const auto& entry : fs::directory_iterator(root)) {
+			expected[entry.path().filename().string()] = ReadContents(entry.path());
+		}
+
+		bool matches = store.Size() == expected.size();
+		for (const auto& [name, contents] : expected) {
+			const CusFile* file = store.Find(name);
+			matches             = matches && file && file->region == contents;
+		}
+
+		std::printf("  %-34s %s\n", scenario, matches ? "ok" : "FAILED");
+		return matches;
+	}
+
+	// Fresh tree and store holding the given files, as after a full load
+	void Reset(CusFileStore& store, const fs::path& root, const std::vector<std::string>& names) {
+		fs::remove_all(root);
+		fs::create_directories(root);
+		store.Clear();
+		for (const std::string& name : names) {
+			Write(root / name, name.substr(0, name.find('.')));
+			store.SetRegion(store.Insert(name).first, name.substr(0, name.find('.')));
+		}
+		store.Publish();
+	}
+} // namespace
+
+int main() {
+	const fs::path root = fs::temp_directory_path() / "PresetWeaverRenameChains";
+	CusFileStore   store;
+	bool           passed = true;
+
+	std::printf("rename chains:\n");
+
+	Reset(store, root, { "x.cus", "y.cus" });
+	fs::rename(root / "x.cus", root / "t.cus");
+	fs::rename(root / "y.cus", root / "x.cus");
+	fs::rename(root / "t.cus", root / "y.cus");
+	Apply(store, root,
+	      {
+	          { ChangeInfo::RENAMED, root / "t.cus", root / "x.cus", nullptr },
+	          { ChangeInfo::RENAMED, root / "x.cus", root / "y.cus", nullptr },
+	          { ChangeInfo::RENAMED, root / "y.cus", root / "t.cus", nullptr },
+	      });
+	passed = Check("swap x->t, y->x, t->y", store, root) && passed;
+
+	Reset(store, root, { "a.cus", "b.cus", "c.cus" });
+	fs::rename(root / "a.cus", root / "t.cus");
+	fs::rename(root / "c.cus", root / "a.cus");
+	fs::rename(root / "b.cus", root / "c.cus");
+	fs::rename(root / "t.cus", root / "b.cus");
+	Apply(store, root,
+	      {
+	          { ChangeInfo::RENAMED, root / "t.cus", root / "a.cus", nullptr },
+	          { ChangeInfo::RENAMED, root / "a.cus", root / "c.cus", nullptr },
+	          { ChangeInfo::RENAMED, root / "c.cus", root / "b.cus", nullptr },
+	          { ChangeInfo::RENAMED, root / "b.cus", root / "t.cus", nullptr },
+	      });
+	passed = Check("rotation a->t, c->a, b->c, t->b", store, root) && passed;
+
+	// Saved through a temporary file over an existing preset, all in one tick
+	Reset(store, root, { "p.cus" });
+	Write(root / "p.cus.tmp", "p2");
+	fs::rename(root / "p.cus.tmp", root / "p.cus");
+	Apply(store, root,
+	      {
+	          { ChangeInfo::ADDED, root / "p.cus.tmp", {}, nullptr },
+	          { ChangeInfo::RENAMED, root / "p.cus", root / "p.cus.tmp", nullptr },
+	      });
+	passed = Check("written then renamed over", store, root) && passed;
+
+	Reset(store, root, { "d.cus" });
+	fs::remove(root / "d.cus");
+	Write(root / "d.cus", "d2");
+	Apply(store, root,
+	      {
+	          { ChangeInfo::DELETED, root / "d.cus", {}, nullptr },
+	          { ChangeInfo::ADDED, root / "d.cus", {}, nullptr },
+	      });
+	passed = Check("deleted then added again", store, root) && passed;
+
+#ifdef __linux__
+	// The same swap as the inotify backend reports it, all three renames in one batch
+	Reset(store, root, { "x.cus", "y.cus" });
+	DirectoryScanOptions options;
+	options.write_settle_period = std::chrono::milliseconds(0);
+	DirectoryMonitor monitor(root, true, DirectoryMonitor::Backend::INOTIFY, options);
+	if (std::string(monitor.GetBackendName()) == "inotify") {
+		fs::rename(root / "x.cus", root / "t.cus");
+		fs::rename(root / "y.cus", root / "x.cus");
+		fs::rename(root / "t.cus", root / "y.cus");
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+		const std::vector<ChangeInfo> changes = monitor.CheckForDirectoryChanges();
+		Apply(store, root, changes);
+		passed = Check(("inotify swap, " + std::to_string(changes.size()) + " changes").c_str(), store, root) && passed;
+	} else {
+		std::printf("  inotify swap                       skipped, backend unavailable\n");
+	}
+#endif
+
+	fs::remove_all(root);
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,224 @@
+// Change events applied to a store of 50k presets: 10k mixed loads, removals, renames and conversions against
+// CusFileStore, published every 100 events as the monitor thread publishes once per batch, and against a replica of the
+// per-region vectors it replaced, which scanned every vector for the path. The replica takes milliseconds per event at
+// this size, so it runs the first 1k events only and its total is projected. Both end the first 1k events in the same
+// state. Run by ctest, exits non-zero when they do not.
+
+#include "CusFileStore.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+	using Clock                                        = std::chrono::steady_clock;
+
+	constexpr size_t                     FILE_COUNT    = 50000;
+	constexpr size_t                     EVENT_COUNT   = 10000;
+	constexpr size_t                     REPLICA_COUNT = 1000;
+	constexpr size_t                     BATCH_SIZE    = 100;
+	constexpr std::array<const char*, 3> REGIONS       = { "USA", "KOR", "RUS" };
+
+	struct Event {
+		enum Type {
+			LOAD, // Added or modified, read again and possibly in another region
+			REMOVE,
+			RENAME,
+			CONVERT
+		};
+
+		Type        type;
+		fs::path    path;
+		fs::path    new_path; // For renames
+		const char* region = nullptr;
+	};
+
+	fs::path PresetPath(size_t index) {
+		return fs::path("Region " + std::to_string(index % 500)) / ("Vehicle Setup " + std::to_string(index) + ".cus");
+	}
+
+	// As CusManager kept presets before CusFileStore: one vector per region, every event scans them all for the path
+	class RegionVectors {
+	public:
+		// As the cold load built the vectors, without looking for the path
+		void Add(const fs::path& path, const char* region) {
+			files[region].push_back(std::make_unique<File>(File { path, region }));
+		}
+
+		void Load(const fs::path& path, const char* region) {
+			Remove(path);
+			files[region].push_back(std::make_unique<File>(File { path, region }));
+		}
+
+		void Remove(const fs::path& path) {
+			for (auto& [region, vector] : files) {
+				auto it = std::remove_if(vector.begin(), vector.end(), [&](const std::unique_ptr<File>& file) { return file->path == path; });
+				if (it != vector.end()) {
+					vector.erase(it, vector.end());
+					break;
+				}
+			}
+		}
+
+		void Rename(const fs::path& path, const fs::path& new_path) {
+			for (auto& [region, vector] : files) {
+				auto it = std::find_if(vector.begin(), vector.end(), [&](const std::unique_ptr<File>& file) { return file->path == path; });
+				if (it == vector.end())
+					continue;
+
+				File* file = it->get();
+				if (new_path != path) {
+					Remove(new_path); // Renamed over an existing preset
+					file->path = new_path;
+				}
+				return;
+			}
+		}
+
+		void Convert(const fs::path& path, const char* region) {
+			for (auto& [old_region, vector] : files) {
+				if (std::find_if(vector.begin(), vector.end(), [&](const std::unique_ptr<File>& file) { return file->path == path; }) != vector.end()) {
+					Load(path, region);
+					return;
+				}
+			}
+		}
+
+		[[nodiscard]] bool Matches(const CusFileStore& store) const {
+			size_t count = 0;
+			for (const auto& [region, vector] : files) {
+				for (const auto& file : vector) {
+					const CusFile* stored = store.Find(file->path);
+					if (!stored || stored->region != region)
+						return false;
+				}
+				count += vector.size();
+			}
+			return count == store.Size();
+		}
+
+	private:
+		struct File {
+			fs::path    path;
+			std::string region;
+		};
+
+		std::unordered_map<std::string, std::vector<std::unique_ptr<File>>> files;
+	};
+
+	void Apply(CusFileStore& store, const Event& event) {
+		switch (event.type) {
+			case Event::LOAD:
+				store.SetRegion(store.Insert(event.path).first, event.region);
+				break;
+			case Event::REMOVE:
+				store.Erase(event.path);
+				break;
+			case Event::RENAME:
+				if (CusFile* file = store.Find(event.path); file && event.new_path != event.path) {
+					store.Erase(event.new_path); // Renamed over an existing preset
+					store.Rename(file, event.new_path);
+				}
+				break;
+			case Event::CONVERT:
+				if (CusFile* file = store.Find(event.path)) {
+					store.SetRegion(file, event.region);
+				}
+				break;
+		}
+	}
+
+	void Apply(RegionVectors& vectors, const Event& event) {
+		switch (event.type) {
+			case Event::LOAD:
+				vectors.Load(event.path, event.region);
+				break;
+			case Event::REMOVE:
+				vectors.Remove(event.path);
+				break;
+			case Event::RENAME:
+				vectors.Rename(event.path, event.new_path);
+				break;
+			case Event::CONVERT:
+				vectors.Convert(event.path, event.region);
+				break;
+		}
+	}
+
+	void Fill(CusFileStore& store) {
+		for (size_t index = 0; index < FILE_COUNT; ++index) {
+			store.SetRegion(store.Insert(PresetPath(index)).first, REGIONS[index % REGIONS.size()]);
+		}
+		store.Publish();
+	}
+
+	void Fill(RegionVectors& vectors) {
+		for (size_t index = 0; index < FILE_COUNT; ++index) {
+			vectors.Add(PresetPath(index), REGIONS[index % REGIONS.size()]);
+		}
+	}
+
+	struct Timing {
+		double events  = 0; // Seconds applying events
+		double publish = 0; // Seconds in CusFileStore::Publish
+	};
+
+	// Applies the first count events, publishing after every batch when the store has snapshots
+	template <typename Store>
+	Timing Replay(Store& store, const std::vector<Event>& events, size_t count) {
+		Timing timing;
+		for (size_t batch = 0; batch < count; batch += BATCH_SIZE) {
+			const Clock::time_point start = Clock::now();
+			for (size_t index = batch; index < std::min(batch + BATCH_SIZE, count); ++index) {
+				Apply(store, events[index]);
+			}
+			const Clock::time_point applied = Clock::now();
+			if constexpr (std::is_same_v<Store, CusFileStore>) {
+				store.Publish();
+			}
+			timing.events  += std::chrono::duration<double>(applied - start).count();
+			timing.publish += std::chrono::duration<double>(Clock::now() - applied).count();
+		}
+		return timing;
+	}
+} // namespace
+
+int main() {
+	// Paths past FILE_COUNT are new, the rest hit loaded presets or ones an earlier event removed or renamed away
+	std::mt19937                          random(42);
+	std::uniform_int_distribution<size_t> any_path(0, FILE_COUNT + FILE_COUNT / 10);
+	std::uniform_int_distribution<int>    any_type(0, 3);
+	std::vector<Event>                    events;
+	for (size_t index = 0; index < EVENT_COUNT; ++index) {
+		const auto type = static_cast<Event::Type>(any_type(random));
+		events.push_back({ type, PresetPath(any_path(random)), type == Event::RENAME ? PresetPath(any_path(random)) : fs::path(), REGIONS[random() % REGIONS.size()] });
+	}
+
+	CusFileStore store;
+	Fill(store);
+	const Timing store_timing = Replay(store, events, EVENT_COUNT);
+
+	CusFileStore  checked_store;
+	RegionVectors vectors;
+	Fill(checked_store);
+	Fill(vectors);
+	Replay(checked_store, events, REPLICA_COUNT);
+	const Timing vector_timing = Replay(vectors, events, REPLICA_COUNT);
+	const bool   matches       = vectors.Matches(checked_store);
+
+	std::printf("%zu events against %zu presets, in batches of %zu:\n", EVENT_COUNT, FILE_COUNT, BATCH_SIZE);
+	std::printf("  CusFileStore        %9.1f ms, %7.2f us per event, plus %.1f ms publishing\n", store_timing.events * 1000, store_timing.events * 1e6 / EVENT_COUNT,
+	            store_timing.publish * 1000);
+	std::printf("  per-region vectors  %9.1f ms, %7.2f us per event, projected from the first %zu\n", vector_timing.events * 1000 * EVENT_COUNT / REPLICA_COUNT,
+	            vector_timing.events * 1e6 / REPLICA_COUNT, REPLICA_COUNT);
+	std::printf("  same state after %zu events: %s\n", REPLICA_COUNT, matches ? "yes" : "NO");
+
+	return matches ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+// Metadata syscalls per file: the original FileInfo construction (fs::exists, last_write_time, is_directory, file_size and
+// a stat for the file_id) against FileInfo::ReadMetadata, and a full polling scan with either directory enumerator. The
+// stat family is counted by interposing the libc wrappers, which std::filesystem calls through as well. Linux only. Run
+// by ctest, exits non-zero when ReadMetadata takes more than one call or a scan more than one per file and directory.
+
+#include "PollingChangeSource.h"
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace {
+	std::atomic<size_t> stat_calls      = 0;
+
+	constexpr int       DIRECTORY_COUNT = 20;
+	constexpr int       PRESETS_PER_DIR = 400;
+	constexpr int       OTHERS_PER_DIR  = 100; // Not .cus, the native enumerator skips their stat
+
+	template <typename Function>
+	Function* Next(const char* name) {
+		return reinterpret_cast<Function*>(dlsym(RTLD_NEXT, name));
+	}
+
+	// As the FileInfo constructor read metadata before the single-call layer
+	void ReadMetadataOriginal(const fs::path& filepath, FileInfo& info) {
+		try {
+			if (fs::exists(filepath)) {
+				info.last_modified = fs::last_write_time(filepath);
+				info.is_directory  = fs::is_directory(filepath);
+				info.size          = info.is_directory ? 0 : fs::file_size(filepath);
+
+				struct stat stat_buf;
+				info.file_id = stat(filepath.c_str(), &stat_buf) == 0 ? (static_cast<uint64_t>(stat_buf.st_dev) << 32) | stat_buf.st_ino : 0;
+			}
+		} catch (const fs::filesystem_error&) {
+			info = FileInfo();
+		}
+	}
+
+	template <typename Function>
+	double CallsPerFile(size_t file_count, Function&& function) {
+		const size_t before = stat_calls.load();
+		function();
+		return static_cast<double>(stat_calls.load() - before) / static_cast<double>(file_count);
+	}
+} // namespace
+
+extern "C" {
+int stat(const char* path, struct stat* buf) {
+	stat_calls++;
+	return Next<int(const char*, struct stat*)>("stat")(path, buf);
+}
+
+int lstat(const char* path, struct stat* buf) {
+	stat_calls++;
+	return Next<int(const char*, struct stat*)>("lstat")(path, buf);
+}
+
+int fstatat(int directory_fd, const char* path, struct stat* buf, int flags) {
+	stat_calls++;
+	return Next<int(int, const char*, struct stat*, int)>("fstatat")(directory_fd, path, buf, flags);
+}
+
+int statx(int directory_fd, const char* path, int flags, unsigned int mask, struct statx* buf) {
+	stat_calls++;
+	return Next<int(int, const char*, int, unsigned int, struct statx*)>("statx")(directory_fd, path, flags, mask, buf);
+}
+}
+
+int main() {
+	const fs::path root = fs::temp_directory_path() / "PresetWeaverSyscallsPerFile";
+	fs::remove_all(root);
+
+	std::vector<fs::path> presets;
+	for (int directory = 0; directory < DIRECTORY_COUNT; ++directory) {
+		const fs::path directory_path = root / ("d" + std::to_string(directory));
+		fs::create_directories(directory_path);
+		for (int file = 0; file < PRESETS_PER_DIR; ++file) {
+			presets.push_back(directory_path / ("p" + std::to_string(file) + ".cus"));
+			std::ofstream(presets.back()) << "preset " << directory << " " << file;
+		}
+		for (int file = 0; file < OTHERS_PER_DIR; ++file) {
+			std::ofstream(directory_path / ("o" + std::to_string(file) + ".txt")) << "other";
+		}
+	}
+
+	FileInfo     info;
+	const double original = CallsPerFile(presets.size(), [&]() {
+		for (const fs::path& preset : presets) {
+			ReadMetadataOriginal(preset, info);
+		}
+	});
+	const double single   = CallsPerFile(presets.size(), [&]() {
+		for (const fs::path& preset : presets) {
+			info = FileInfo::ReadMetadata(preset);
+		}
+	});
+
+	// Full scans as on construction, one thread so every call is on this one
+	DirectoryScanOptions options;
+	options.thread_count       = 1;
+	options.native_enumeration = false;
+	const double portable_scan = CallsPerFile(presets.size(), [&]() {
+		PollingChangeSource source(root, true, options);
+	});
+	options.native_enumeration = true;
+	const double native_scan   = CallsPerFile(presets.size(), [&]() {
+		PollingChangeSource source(root, true, options);
+	});
+
+	std::printf("stat-family calls per preset (%zu presets, %d other files per directory):\n", presets.size(), OTHERS_PER_DIR);
+	std::printf("  original FileInfo construction  %.3f\n", original);
+	std::printf("  FileInfo::ReadMetadata          %.3f\n", single);
+	std::printf("  full scan, std::filesystem      %.3f\n", portable_scan);
+	std::printf("  full scan, getdents64           %.3f\n", native_scan);
+
+	fs::remove_all(root);
+	const double per_directory = static_cast<double>(DIRECTORY_COUNT + 1) / static_cast<double>(presets.size());
+	return single == 1.0 && native_scan <= 1.0 + per_directory && original > single ? 0 : 1;
+}